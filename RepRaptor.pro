@@ -5,7 +5,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui serialport concurrent
+QT       += core gui serialport concurrent network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -13,6 +13,11 @@ TARGET = RepRaptor
 TEMPLATE = app
 CONFIG += static
 
+#Count heap allocations of the send path, qmake CONFIG+=alloccount
+alloccount {
+    DEFINES += ALLOCATION_COUNTER
+}
+
 unix {
     #VARIABLES
     isEmpty(PREFIX) {
@@ -44,7 +49,32 @@ SOURCES += main.cpp\
     erroricon.cpp \
     sdwindow.cpp \
     eepromwindow.cpp \
-    parser.cpp
+    parser.cpp \
+    commandqueue.cpp \
+    temperaturehistory.cpp \
+    temperaturegraph.cpp \
+    temperaturewindow.cpp \
+    gcodecommand.cpp \
+    toolpath.cpp \
+    toolpathview.cpp \
+    toolpathwindow.cpp \
+    gcodevalidator.cpp \
+    sdfilemodel.cpp \
+    eeprommodel.cpp \
+    machinestate.cpp \
+    wirelogger.cpp \
+    controlserver.cpp \
+    linkprobe.cpp \
+    jobqueue.cpp \
+    gcodestore.cpp \
+    allocationcounter.cpp \
+    telemetry.cpp \
+    lineencoder.cpp \
+    segmentmerger.cpp \
+    latencyprofile.cpp \
+    latencywindow.cpp \
+    portwatcher.cpp \
+    startupprofile.cpp
 
 HEADERS  += mainwindow.h \
     settingswindow.h \
@@ -54,14 +84,42 @@ HEADERS  += mainwindow.h \
     sdwindow.h \
     repraptor.h \
     eepromwindow.h \
-    parser.h
+    parser.h \
+    commandqueue.h \
+    temperaturehistory.h \
+    temperaturegraph.h \
+    temperaturewindow.h \
+    gcodecommand.h \
+    toolpath.h \
+    toolpathview.h \
+    toolpathwindow.h \
+    gcodevalidator.h \
+    sdfilemodel.h \
+    eeprommodel.h \
+    machinestate.h \
+    wirelogger.h \
+    controlserver.h \
+    linkprobe.h \
+    jobqueue.h \
+    gcodestore.h \
+    allocationcounter.h \
+    telemetry.h \
+    lineencoder.h \
+    segmentmerger.h \
+    latencyprofile.h \
+    latencywindow.h \
+    portwatcher.h \
+    startupprofile.h
 
 FORMS    += mainwindow.ui \
     settingswindow.ui \
     aboutwindow.ui \
     errorwindow.ui \
     sdwindow.ui \
-    eepromwindow.ui
+    eepromwindow.ui \
+    temperaturewindow.ui \
+    toolpathwindow.ui \
+    latencywindow.ui
 
 RESOURCES += \
     graphics.qrc
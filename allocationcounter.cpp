@@ -0,0 +1,49 @@
+#include "allocationcounter.h"
+
+#ifdef ALLOCATION_COUNTER
+
+#include <QAtomicInt>
+#include <new>
+#include <stdlib.h>
+
+static QAtomicInt allocations;
+
+void *operator new(size_t size)
+{
+    allocations.fetchAndAddRelaxed(1);
+    void *p = malloc(size ? size : 1);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    allocations.fetchAndAddRelaxed(1);
+    void *p = malloc(size ? size : 1);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) Q_DECL_NOTHROW
+{
+    free(p);
+}
+
+void operator delete[](void *p) Q_DECL_NOTHROW
+{
+    free(p);
+}
+
+int AllocationCounter::count()
+{
+    return allocations.load();
+}
+
+#else
+
+int AllocationCounter::count()
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+//Counts every operator new of the program when built with
+//CONFIG+=alloccount, to check that the send path stays allocation-free.
+//Without it nothing is replaced and count() is always 0.
+namespace AllocationCounter
+{
+    int count();
+}
+
+#endif // ALLOCATIONCOUNTER_H
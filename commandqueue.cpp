@@ -0,0 +1,73 @@
+#include "commandqueue.h"
+
+CommandQueue::CommandQueue()
+{
+
+}
+
+void CommandQueue::enqueue(const QString &command, CommandLane lane)
+{
+    //Multiline commands are split, so every line gets its own "ok"
+    foreach (const QString &line, command.split('\n', QString::SkipEmptyParts))
+    {
+        switch(lane)
+        {
+        case EmergencyLane:
+            emergencyLane.enqueue(line);
+            break;
+        case StatusLane:
+            //Status queries are idempotent, one pending copy is enough
+            if(!pendingStatus.contains(line))
+            {
+                pendingStatus.insert(line);
+                statusLane.enqueue(line);
+            }
+            break;
+        case UserLane:
+        default:
+            userLane.enqueue(line);
+            break;
+        }
+    }
+}
+
+QString CommandQueue::dequeue(CommandLane *lane)
+{
+    if(!emergencyLane.isEmpty())
+    {
+        if(lane) *lane = EmergencyLane;
+        return emergencyLane.dequeue();
+    }
+    else if(!userLane.isEmpty())
+    {
+        if(lane) *lane = UserLane;
+        return userLane.dequeue();
+    }
+    else if(!statusLane.isEmpty())
+    {
+        if(lane) *lane = StatusLane;
+        QString line = statusLane.dequeue();
+        pendingStatus.remove(line);
+        return line;
+    }
+
+    return QString();
+}
+
+bool CommandQueue::hasEmergency() const
+{
+    return !emergencyLane.isEmpty();
+}
+
+bool CommandQueue::isEmpty() const
+{
+    return emergencyLane.isEmpty() && userLane.isEmpty() && statusLane.isEmpty();
+}
+
+void CommandQueue::clear()
+{
+    emergencyLane.clear();
+    userLane.clear();
+    statusLane.clear();
+    pendingStatus.clear();
+}
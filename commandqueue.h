@@ -0,0 +1,30 @@
+#ifndef COMMANDQUEUE_H
+#define COMMANDQUEUE_H
+
+#include <QQueue>
+#include <QSet>
+#include <QString>
+
+#include "repraptor.h"
+
+using namespace RepRaptor;
+
+class CommandQueue
+{
+public:
+    CommandQueue();
+
+    void enqueue(const QString &command, CommandLane lane = UserLane);
+    QString dequeue(CommandLane *lane = 0);
+    bool hasEmergency() const;
+    bool isEmpty() const;
+    void clear();
+
+protected:
+    QQueue<QString> emergencyLane;
+    QQueue<QString> userLane;
+    QQueue<QString> statusLane;
+    QSet<QString> pendingStatus; //Status queries waiting in statusLane
+};
+
+#endif // COMMANDQUEUE_H
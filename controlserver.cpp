@@ -0,0 +1,180 @@
+#include "controlserver.h"
+
+ControlServer::ControlServer(QObject *parent) :
+    QObject(parent)
+{
+    connect(&server, SIGNAL(newConnection()), this, SLOT(newClient()));
+}
+
+ControlServer::~ControlServer()
+{
+    server.close();
+}
+
+bool ControlServer::listen(const QString &name)
+{
+    QLocalServer::removeServer(name); //Left over if the last run crashed
+    server.setSocketOptions(QLocalServer::UserAccessOption);
+    return server.listen(name);
+}
+
+void ControlServer::connectParser(Parser *parser)
+{
+    connect(parser, &Parser::recievedTemperature, this, &ControlServer::temperature);
+    connect(parser, &Parser::recievedSDUpdate, this, &ControlServer::sdProgress);
+    connect(parser, &Parser::recievedError, this, &ControlServer::error);
+    connect(parser, &Parser::recievedStart, this, &ControlServer::start);
+    connect(parser, &Parser::recievedResend, this, &ControlServer::resend);
+}
+
+void ControlServer::newClient()
+{
+    while(server.hasPendingConnections())
+    {
+        QLocalSocket *client = server.nextPendingConnection();
+
+        connect(client, SIGNAL(readyRead()), this, SLOT(readClient()));
+        connect(client, SIGNAL(disconnected()), this, SLOT(removeClient()));
+        clients.append(client);
+
+        QJsonObject hello = status;
+        hello["event"] = QString("status");
+        send(client, hello);
+    }
+}
+
+void ControlServer::removeClient()
+{
+    QLocalSocket *client = qobject_cast<QLocalSocket*>(sender());
+    if(!client) return;
+
+    clients.removeAll(client);
+    client->deleteLater();
+}
+
+void ControlServer::readClient()
+{
+    QLocalSocket *client = qobject_cast<QLocalSocket*>(sender());
+    if(!client) return;
+
+    while(client->canReadLine())
+    {
+        QJsonParseError e;
+        QJsonDocument request = QJsonDocument::fromJson(client->readLine(), &e);
+
+        if(e.error != QJsonParseError::NoError || !request.isObject())
+        {
+            QJsonObject reply;
+            reply["ok"] = false;
+            reply["error"] = QString("Bad request: ") + e.errorString();
+            send(client, reply);
+        }
+        else handle(client, request.object());
+    }
+}
+
+void ControlServer::handle(QLocalSocket *client, const QJsonObject &request)
+{
+    QString cmd = request.value("cmd").toString();
+    QString error;
+    QJsonObject reply;
+
+    reply["ok"] = true;
+    if(request.contains("id")) reply["id"] = request.value("id"); //Lets clients match replies to requests
+
+    if(cmd == "status")
+    {
+        for(QJsonObject::const_iterator i = status.constBegin(); i != status.constEnd(); ++i)
+            reply.insert(i.key(), i.value());
+    }
+    else if(cmd == "inject")
+    {
+        QString lane = request.value("lane").toString("user");
+
+        if(lane == "emergency") emit injectRequested(request.value("line").toString(), EmergencyLane, &error);
+        else if(lane == "status") emit injectRequested(request.value("line").toString(), StatusLane, &error);
+        else emit injectRequested(request.value("line").toString(), UserLane, &error);
+    }
+    else if(cmd == "open") emit openRequested(request.value("file").toString(), &error);
+    else if(cmd == "start") emit startRequested(&error);
+    else if(cmd == "pause") emit pauseRequested(&error);
+    else if(cmd == "stop") emit stopRequested(&error);
+    else error = "Unknown command " + cmd;
+
+    if(!error.isEmpty())
+    {
+        reply["ok"] = false;
+        reply["error"] = error;
+    }
+
+    send(client, reply);
+}
+
+void ControlServer::send(QLocalSocket *client, const QJsonObject &message)
+{
+    client->write(QJsonDocument(message).toJson(QJsonDocument::Compact) + '\n');
+}
+
+void ControlServer::publish(const QJsonObject &event)
+{
+    if(clients.isEmpty()) return;
+
+    QByteArray data = QJsonDocument(event).toJson(QJsonDocument::Compact) + '\n';
+
+    foreach(QLocalSocket *client, clients)
+    {
+        if(client->bytesToWrite() > MaxBacklog) continue; //Slow reader, it gets the next status
+        client->write(data);
+    }
+}
+
+void ControlServer::setStatus(const QJsonObject &status)
+{
+    if(status == this->status) return;
+
+    this->status = status;
+
+    QJsonObject event = status;
+    event["event"] = QString("status");
+    publish(event);
+}
+
+void ControlServer::temperature(TemperatureReadings r)
+{
+    QJsonObject event;
+    event["event"] = QString("temperature");
+    event["e"] = r.e;
+    event["b"] = r.b;
+    publish(event);
+}
+
+void ControlServer::sdProgress(SDProgress p)
+{
+    QJsonObject event;
+    event["event"] = QString("sdprogress");
+    event["progress"] = double(p.progress);
+    event["total"] = double(p.total);
+    publish(event);
+}
+
+void ControlServer::error()
+{
+    QJsonObject event;
+    event["event"] = QString("error");
+    publish(event);
+}
+
+void ControlServer::start()
+{
+    QJsonObject event;
+    event["event"] = QString("start");
+    publish(event);
+}
+
+void ControlServer::resend(int line)
+{
+    QJsonObject event;
+    event["event"] = QString("resend");
+    event["line"] = line;
+    publish(event);
+}
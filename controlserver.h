@@ -0,0 +1,67 @@
+#ifndef CONTROLSERVER_H
+#define CONTROLSERVER_H
+
+#include <QObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+
+#include "repraptor.h"
+#include "parser.h"
+
+using namespace RepRaptor;
+
+//Local socket for automation, one JSON object per line both ways.
+//Requests: {"cmd":"status"}, {"cmd":"inject","line":"G28","lane":"user"},
+//{"cmd":"open","file":"..."}, {"cmd":"start"}, {"cmd":"pause"}, {"cmd":"stop"}.
+//Every request gets {"ok":true} or {"ok":false,"error":"..."} when it was refused.
+//Parser events and status changes are pushed to every client; a client
+//that does not read is skipped instead of being waited for.
+class ControlServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ControlServer(QObject *parent = 0);
+    ~ControlServer();
+
+    bool listen(const QString &name);
+    inline bool isListening() const { return server.isListening(); }
+    void connectParser(Parser *parser);
+
+protected:
+    enum { MaxBacklog = 256 * 1024 }; //Unsent bytes before events are dropped for a client
+
+    QLocalServer server;
+    QList<QLocalSocket*> clients;
+    QJsonObject status;
+
+    void send(QLocalSocket *client, const QJsonObject &message);
+    void handle(QLocalSocket *client, const QJsonObject &request);
+
+signals:
+    //Connected directly, a receiver that refuses the request sets error
+    void injectRequested(QString command, CommandLane lane, QString *error);
+    void openRequested(QString filename, QString *error);
+    void startRequested(QString *error);
+    void pauseRequested(QString *error);
+    void stopRequested(QString *error);
+
+public slots:
+    void publish(const QJsonObject &event);
+    void setStatus(const QJsonObject &status);
+
+protected slots:
+    void newClient();
+    void readClient();
+    void removeClient();
+    void temperature(TemperatureReadings r);
+    void sdProgress(SDProgress p);
+    void error();
+    void start();
+    void resend(int line);
+};
+
+#endif // CONTROLSERVER_H
@@ -0,0 +1,166 @@
+#include "eeprommodel.h"
+
+#include <QFont>
+
+static const int fetchBatch = 64;
+
+EEPROMModel::EEPROMModel(QObject *parent) :
+    QAbstractTableModel(parent)
+{
+    shown = 0;
+}
+
+EEPROMModel::~EEPROMModel()
+{
+
+}
+
+int EEPROMModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : shown;
+}
+
+int EEPROMModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant EEPROMModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || index.row() >= shown) return QVariant();
+
+    const EEPROMSetting &s = settings.at(index.row());
+
+    if(role == Qt::DisplayRole || role == Qt::EditRole)
+    {
+        if(index.column() == DescriptionColumn) return s.description;
+        else if(index.column() == ValueColumn) return s.value;
+    }
+    else if(role == Qt::FontRole && isChanged(index.row()))
+    {
+        QFont font;
+        font.setBold(true);
+        return font;
+    }
+
+    return QVariant();
+}
+
+QVariant EEPROMModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if(orientation != Qt::Horizontal || role != Qt::DisplayRole) return QVariant();
+
+    if(section == DescriptionColumn) return QString("Setting");
+    else if(section == ValueColumn) return QString("Value");
+
+    return QVariant();
+}
+
+bool EEPROMModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if(role != Qt::EditRole || index.column() != ValueColumn || index.row() >= shown) return false;
+
+    settings[index.row()].value = value.toString().trimmed();
+    emit dataChanged(this->index(index.row(), 0), this->index(index.row(), ColumnCount - 1));
+
+    return true;
+}
+
+Qt::ItemFlags EEPROMModel::flags(const QModelIndex &index) const
+{
+    Qt::ItemFlags f = QAbstractTableModel::flags(index);
+    if(index.column() == ValueColumn) f |= Qt::ItemIsEditable;
+    return f;
+}
+
+bool EEPROMModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && shown < settings.size();
+}
+
+void EEPROMModel::fetchMore(const QModelIndex &parent)
+{
+    if(parent.isValid()) return;
+
+    int count = qMin(fetchBatch, settings.size() - shown);
+    if(count <= 0) return;
+
+    beginInsertRows(QModelIndex(), shown, shown + count - 1);
+    shown += count;
+    endInsertRows();
+}
+
+const EEPROMSetting &EEPROMModel::setting(int row) const
+{
+    return settings.at(row);
+}
+
+bool EEPROMModel::isChanged(int row) const
+{
+    return settings.at(row).value != original.at(row);
+}
+
+QStringList EEPROMModel::changes(int firmware) const
+{
+    QStringList gcode;
+
+    if(firmware == Repetier)
+    {
+        //Repetier takes one setting per M206
+        for(int i = 0; i < settings.size(); i++)
+        {
+            if(!isChanged(i)) continue;
+
+            const EEPROMSetting &s = settings.at(i);
+            gcode.append("M206 T" + QString::number(s.type)
+                         + " P" + QString::number(s.position)
+                         + (s.type == EEPROMFloat ? " X" : " S") + s.value);
+        }
+    }
+    else if(firmware == Marlin)
+    {
+        //Changed values are sent with the rest of their M503 line,
+        //so index parameters (like S in M145) stay in place
+        for(int i = 0; i < settings.size(); )
+        {
+            int group = settings.at(i).group;
+            QString command = settings.at(i).command;
+            bool dirty = false;
+
+            for(; i < settings.size() && settings.at(i).group == group; i++)
+            {
+                command += " " + QString(settings.at(i).parameter) + settings.at(i).value;
+                if(isChanged(i)) dirty = true;
+            }
+
+            if(dirty) gcode.append(command);
+        }
+
+        if(!gcode.isEmpty()) gcode.append("M500"); //Store to EEPROM
+    }
+
+    return gcode;
+}
+
+void EEPROMModel::append(EEPROMSetting setting)
+{
+    settings.append(setting);
+    original.append(setting.value);
+
+    //First batch is shown right away, the rest when the view scrolls there
+    if(shown < fetchBatch && shown == settings.size() - 1)
+    {
+        beginInsertRows(QModelIndex(), shown, shown);
+        shown++;
+        endInsertRows();
+    }
+}
+
+void EEPROMModel::clear()
+{
+    beginResetModel();
+    settings.clear();
+    original.clear();
+    shown = 0;
+    endResetModel();
+}
@@ -0,0 +1,53 @@
+#ifndef EEPROMMODEL_H
+#define EEPROMMODEL_H
+
+#include <QAbstractTableModel>
+#include <QVector>
+#include <QStringList>
+
+#include "repraptor.h"
+
+using namespace RepRaptor;
+
+//Printer settings filled by the parser while M503/M205 output arrives.
+//Rows are handed to the view in batches, edits are kept next to the
+//values read from the printer so only the difference is written back.
+class EEPROMModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column
+    {
+        DescriptionColumn,
+        ValueColumn,
+        ColumnCount
+    };
+
+    explicit EEPROMModel(QObject *parent = 0);
+    ~EEPROMModel();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole);
+    Qt::ItemFlags flags(const QModelIndex &index) const;
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
+
+    const EEPROMSetting &setting(int row) const;
+    bool isChanged(int row) const;
+    QStringList changes(int firmware) const;
+
+public slots:
+    void append(EEPROMSetting setting);
+    void clear();
+
+protected:
+    QVector<EEPROMSetting> settings;
+    QVector<QString> original;
+    int shown; //Rows the view knows about
+};
+
+#endif // EEPROMMODEL_H
@@ -1,88 +1,55 @@
 #include "eepromwindow.h"
 #include "ui_eepromwindow.h"
 
-EEPROMWindow::EEPROMWindow(QStringList eepromLines, QWidget *parent) :
-    QDialog(parent),
-    ui(new Ui::EEPROMWindow)
+EEPROMDelegate::EEPROMDelegate(EEPROMModel *model, QObject *parent) :
+    QStyledItemDelegate(parent)
 {
-    ui->setupUi(this);
-
-    QSettings settings;
-    firmware = settings.value("printer/firmware").toInt();
+    this->model = model;
+}
 
-    QLayout *layout = new QVBoxLayout();
+QWidget *EEPROMDelegate::createEditor(QWidget *parent, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    QLineEdit *edit = new QLineEdit(parent);
+    Q_UNUSED(option);
 
-    if(firmware == Repetier)
+    switch(model->setting(index.row()).type) // set right validator for the line
     {
-        int j = 0;
-        foreach (QString str, eepromLines)
-        {
-            str.remove("EPR:"); // Clear the unneeded part
-
-            repetierEEPROMline currentLine; //Storage for EEPROM values
-
-            QStringList tmp = str.split(' ');
-
-            currentLine.T = tmp.at(0).toInt();
-            currentLine.P = tmp.at(1).toInt();
-            currentLine.S = tmp.at(2);
-
-            lines.append(currentLine);
-
-            QString msg;
-            for(int i = 3; i < tmp.size(); i++) msg+=(tmp.at(i) + " "); //Rejoin the rest
-
-            QLayout *line = new QGridLayout();
-
-            QLabel *label = new QLabel(msg, this);
-            QLineEdit *edit = new QLineEdit(currentLine.S,this);
-
-            QFrame* hline = new QFrame();
-            hline->setFrameShape(QFrame::HLine);
-            hline->setFrameShadow(QFrame::Sunken);
-            line->addWidget(hline);
-
-            edit->setObjectName("e"+QString::number(j)); //Name the LineEdit, so when it emits signal we know where it came from
-
-            QRegExpValidator *doublevalidator = new QRegExpValidator(
-                                                    QRegExp("^\\-?\\d+\\.?\\d+(e\\-?\\d+)?$",
-                                                    Qt::CaseInsensitive), this);
-            doublevalidator->setLocale(QLocale::English);
-
-            switch(currentLine.T) // set right validator for the line
-            {
-            case 0:
-                edit->setValidator(new QIntValidator(-128, 255, this));
-            case 1:
-            case 2:
-                edit->setValidator(new QIntValidator(this));
-                break;
-            case 3:
-                edit->setValidator(doublevalidator);
-                break;
-            default:
-                break;
-            }
-
-            connect(edit, SIGNAL(textChanged(QString)), this, SLOT(lineChanged(QString)));
-
-            line->addWidget(label);
-            line->addWidget(edit);
-
-            line->setMargin(2);
+    case EEPROMByte:
+        edit->setValidator(new QIntValidator(-128, 255, edit));
+        break;
+    case EEPROMInt:
+    case EEPROMLong:
+        edit->setValidator(new QIntValidator(edit));
+        break;
+    case EEPROMFloat:
+    {
+        QRegExpValidator *doublevalidator = new QRegExpValidator(
+                                                QRegExp("^\\-?\\d+\\.?\\d*(e\\-?\\d+)?$",
+                                                Qt::CaseInsensitive), edit);
+        doublevalidator->setLocale(QLocale::English);
+        edit->setValidator(doublevalidator);
+        break;
+    }
+    default:
+        break;
+    }
 
-            layout->addItem(line);
+    return edit;
+}
 
-            j++; // increase counter
-        }
+EEPROMWindow::EEPROMWindow(EEPROMModel *model, int firmware, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::EEPROMWindow)
+{
+    ui->setupUi(this);
 
-    for(int i = 0; i < lines.size(); i++) changed.append(false);
-    ui->eepromWidgets->setLayout(layout);
-    }
-    else if(firmware == Marlin)
-    {
+    this->firmware = firmware; //May be detected on connect rather than set
+    this->model = model;
 
-    }
+    ui->settingsview->setModel(model);
+    ui->settingsview->setItemDelegateForColumn(EEPROMModel::ValueColumn, new EEPROMDelegate(model, this));
+    ui->settingsview->horizontalHeader()->setSectionResizeMode(EEPROMModel::DescriptionColumn, QHeaderView::Stretch);
+    ui->settingsview->horizontalHeader()->setSectionResizeMode(EEPROMModel::ValueColumn, QHeaderView::ResizeToContents);
 }
 
 EEPROMWindow::~EEPROMWindow()
@@ -90,50 +57,7 @@ EEPROMWindow::~EEPROMWindow()
     delete ui;
 }
 
-void EEPROMWindow::lineChanged(QString s)
-{
-    if(firmware == Repetier)
-    {
-        int num = sender()->objectName().remove(0, 1).toInt();
-
-        lines[num].S = s;
-        changed[num] = true;
-    }
-    else if(firmware == Marlin)
-    {
-
-    }
-}
-
 void EEPROMWindow::on_buttonBox_accepted()
 {
-    QStringList gcode;
-
-    if(firmware == Repetier)
-    {
-        for(int i=0; i < changed.size(); i++)
-        {
-            if(changed.at(i))
-            {
-                QString command;
-
-                command+=QString("M206");
-                command+=QString("T");
-                command+=QString::number(lines.at(i).T);
-                command+=QString("P");
-                command+=QString::number(lines.at(i).P);
-                if(lines.at(i).T == 3) command+=QString("X");
-                else command+=QString("S");
-                command+=lines.at(i).S;
-
-                gcode.append(command);
-            }
-        }
-    }
-    else if(firmware == Marlin)
-    {
-
-    }
-
-    emit changesComplete(gcode);
+    emit changesComplete(model->changes(firmware));
 }
@@ -5,6 +5,7 @@
 #include <QtWidgets>
 
 #include "repraptor.h"
+#include "eeprommodel.h"
 
 using namespace RepRaptor;
 
@@ -12,18 +13,31 @@ namespace Ui {
 class EEPROMWindow;
 }
 
+//Gives every value editor a validator matching the setting type
+class EEPROMDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    explicit EEPROMDelegate(EEPROMModel *model, QObject *parent = 0);
+
+    QWidget *createEditor(QWidget *parent, const QStyleOptionViewItem &option, const QModelIndex &index) const;
+
+protected:
+    EEPROMModel *model;
+};
+
 class EEPROMWindow : public QDialog
 {
     Q_OBJECT
 
 public:
-    explicit EEPROMWindow(QStringList eepromLines, QWidget *parent = 0);
+    explicit EEPROMWindow(EEPROMModel *model, int firmware, QWidget *parent = 0);
     ~EEPROMWindow();
 
 private:
     Ui::EEPROMWindow *ui;
-    QVector <repetierEEPROMline> lines;
-    QVector <bool> changed;
+    EEPROMModel *model;
     int firmware;
 
 signals:
@@ -31,7 +45,6 @@ signals:
 
 private slots:
     void on_buttonBox_accepted();
-    void lineChanged(QString s);
 };
 
 #endif // EEPROMWINDOW_H
@@ -0,0 +1,81 @@
+#include "gcodecommand.h"
+
+static const char *parseNumber(const char *p, const char *end, double &value)
+{
+    bool negative = false;
+    double v = 0;
+
+    if(p < end && (*p == '-' || *p == '+'))
+    {
+        negative = (*p == '-');
+        p++;
+    }
+    while(p < end && *p >= '0' && *p <= '9') v = v*10 + (*p++ - '0');
+    if(p < end && *p == '.')
+    {
+        double f = 0.1;
+        for(p++; p < end && *p >= '0' && *p <= '9'; p++)
+        {
+            v += (*p - '0') * f;
+            f *= 0.1;
+        }
+    }
+
+    value = negative ? -v : v;
+    return p;
+}
+
+GCodeCommand::GCodeCommand()
+{
+    letter = 0;
+    code = 0;
+    mask = 0;
+}
+
+bool GCodeCommand::parse(const char *line, int length)
+{
+    const char *p = line;
+    const char *end = line + length;
+
+    letter = 0;
+    code = 0;
+    mask = 0;
+
+    while(p < end)
+    {
+        char c = *p;
+
+        if(c == ';' || c == '*' || c == '\n' || c == '\r') break; //Comment or checksum
+        if(c == '(') //Inline comment
+        {
+            while(p < end && *p != ')') p++;
+            p++;
+            continue;
+        }
+        if(c >= 'a' && c <= 'z') c -= 'a' - 'A';
+        if(c < 'A' || c > 'Z')
+        {
+            p++;
+            continue;
+        }
+
+        double v;
+        const char *next = parseNumber(p + 1, end, v);
+
+        if(c == 'N' && !letter); //Line number
+        else if(!letter && (c == 'G' || c == 'M' || c == 'T'))
+        {
+            letter = c;
+            code = int(v);
+        }
+        else
+        {
+            mask |= 1u << (c - 'A');
+            values[c - 'A'] = v;
+        }
+
+        p = next; //Letters without a number, like G28 X, are flags with value 0
+    }
+
+    return letter != 0;
+}
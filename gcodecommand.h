@@ -0,0 +1,27 @@
+#ifndef GCODECOMMAND_H
+#define GCODECOMMAND_H
+
+#include <QtGlobal>
+
+//Allocation-free scanner for a single line of G-code.
+//Works on raw bytes, skips N line numbers, checksums and comments.
+class GCodeCommand
+{
+public:
+    GCodeCommand();
+
+    char letter; //G, M or T, 0 if the line has no command
+    int code;
+
+    bool parse(const char *line, int length);
+
+    inline bool is(char l, int c) const { return letter == l && code == c; }
+    inline bool has(char p) const { return mask & (1u << (p - 'A')); }
+    inline double value(char p) const { return values[p - 'A']; }
+
+protected:
+    quint32 mask;
+    double values[26];
+};
+
+#endif // GCODECOMMAND_H
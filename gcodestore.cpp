@@ -0,0 +1,123 @@
+#include "gcodestore.h"
+
+#include <string.h>
+
+static const quint32 emptySlot = ~0u;
+
+GCodeStore::GCodeStore()
+{
+    internedCount = 0;
+    estimate = 0;
+    merged.before = merged.after = 0;
+    merged.deviation = 0;
+}
+
+void GCodeStore::mark(char kind, const char *name, int length, double time)
+{
+    Mark m;
+    m.line = index.size();
+    m.kind = kind;
+    m.name = QByteArray(name, length);
+    m.time = time;
+    notes.append(m);
+}
+
+void GCodeStore::clear()
+{
+    blocks.clear();
+    index.clear();
+    interned.clear();
+    internedCount = 0;
+    notes.clear();
+    estimate = 0;
+    merged.before = merged.after = 0;
+    merged.deviation = 0;
+}
+
+void GCodeStore::squeeze()
+{
+    if(!blocks.isEmpty()) blocks.last().squeeze(); //Drop the growth reserve of the last block
+    index.squeeze();
+    notes.squeeze();
+}
+
+void GCodeStore::append(const GCodeStore &other)
+{
+    //Blocks are shared, only the references move to the new block numbers
+    quint32 base = quint32(blocks.size()) << OffsetBits;
+    blocks += other.blocks;
+    index.reserve(index.size() + other.index.size());
+    for(int i = 0; i < other.index.size(); i++) index.append(other.index.at(i) + base);
+}
+
+int GCodeStore::length(int i) const
+{
+    const char *p = line(i);
+    return (const char*)memchr(p, '\n', BlockSize) - p;
+}
+
+qint64 GCodeStore::memoryUsed() const
+{
+    qint64 bytes = index.capacity() * sizeof(quint32) + interned.capacity() * sizeof(quint32)
+            + notes.capacity() * sizeof(Mark);
+    for(int i = 0; i < blocks.size(); i++) bytes += blocks.at(i).capacity();
+    return bytes;
+}
+
+quint32 GCodeStore::store(const char *line, int length)
+{
+    if(blocks.isEmpty() || blocks.last().size() + length + 1 > BlockSize)
+    {
+        blocks.append(QByteArray());
+        blocks.last().reserve(64 * 1024);
+    }
+
+    QByteArray &block = blocks.last();
+    quint32 ref = (quint32(blocks.size() - 1) << OffsetBits) | block.size();
+
+    block.append(line, length);
+    block.append('\n');
+
+    return ref;
+}
+
+void GCodeStore::append(const char *line, int length)
+{
+    if(length > BlockSize - 1) length = BlockSize - 1;
+
+    if(length > InternLength)
+    {
+        index.append(store(line, length));
+        return;
+    }
+
+    if(interned.isEmpty()) interned.fill(emptySlot, InternSlots);
+
+    //FNV-1a over the line, then linear probing
+    quint32 hash = 2166136261u;
+    for(int i = 0; i < length; i++) hash = (hash ^ uchar(line[i])) * 16777619u;
+
+    for(quint32 slot = hash & (InternSlots - 1); ; slot = (slot + 1) & (InternSlots - 1))
+    {
+        quint32 ref = interned.at(slot);
+
+        if(ref == emptySlot)
+        {
+            ref = store(line, length);
+            if(internedCount < InternSlots / 2) //Keep probes short, later lines are just stored
+            {
+                interned[slot] = ref;
+                internedCount++;
+            }
+            index.append(ref);
+            return;
+        }
+
+        const char *known = blocks.at(ref >> OffsetBits).constData() + (ref & OffsetMask);
+        if(!memcmp(known, line, length) && known[length] == '\n')
+        {
+            index.append(ref);
+            return;
+        }
+    }
+}
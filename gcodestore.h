@@ -0,0 +1,92 @@
+#ifndef GCODESTORE_H
+#define GCODESTORE_H
+
+#include <QVector>
+#include <QByteArray>
+#include <QString>
+
+//All lines of a file packed one after another in large blocks, each
+//ending with '\n' so it can be written to the port as it is.
+//A line is found by a 32-bit reference, block << 24 | offset.
+//Short lines that repeat a lot (G92 E0, M107, retractions)
+//are stored once and shared by reference.
+//Slicer notes found between the lines are kept as marks.
+class GCodeStore
+{
+public:
+    GCodeStore();
+
+    enum MarkKind {LayerMark = 'L', TypeMark = 'T'};
+    typedef struct
+    {
+        int line;           //First line after the note
+        char kind;
+        QByteArray name;
+        double time;        //Estimated seconds from the start of the file
+    } Mark;
+
+    typedef struct
+    {
+        int before, after;  //G1 segments
+        double deviation;   //Largest distance of a dropped point, mm
+    } MergeStats;
+
+    void append(const char *line, int length);
+    inline void append(const QByteArray &line) { append(line.constData(), line.size()); }
+    inline void appendUnique(const char *line, int length) { index.append(store(line, length)); } //Never interned
+    void append(const GCodeStore &other);
+    void mark(char kind, const char *name, int length, double time = 0);
+    inline const QVector<Mark> &marks() const { return notes; }
+    inline void setMarks(const QVector<Mark> &marks) { notes = marks; }
+    inline void setDuration(double seconds) { estimate = seconds; }
+    inline double duration() const { return estimate; }
+    inline void setMergeStats(const MergeStats &stats) { merged = stats; }
+    inline MergeStats mergeStats() const { return merged; }
+    void clear();
+    void squeeze();
+    inline void swap(GCodeStore &other)
+    {
+        blocks.swap(other.blocks);
+        index.swap(other.index);
+        interned.swap(other.interned);
+        qSwap(internedCount, other.internedCount);
+        notes.swap(other.notes);
+        qSwap(estimate, other.estimate);
+        qSwap(merged, other.merged);
+    }
+
+    inline int size() const { return index.size(); }
+    inline bool isEmpty() const { return index.isEmpty(); }
+
+    //Text of the line followed by '\n', stays valid until the store changes
+    inline const char *line(int i) const
+    {
+        quint32 ref = index.at(i);
+        return blocks.at(ref >> OffsetBits).constData() + (ref & OffsetMask);
+    }
+    int length(int i) const; //Without the '\n'
+    inline QString at(int i) const { return QString::fromLatin1(line(i), length(i)); }
+    qint64 memoryUsed() const;
+
+protected:
+    enum
+    {
+        OffsetBits = 24,
+        OffsetMask = (1 << OffsetBits) - 1,
+        BlockSize = 1 << OffsetBits,    //16 MB
+        InternLength = 16,              //Longer lines are rarely repeated
+        InternSlots = 4096
+    };
+
+    QVector<QByteArray> blocks;
+    QVector<quint32> index;
+    QVector<quint32> interned;          //Open addressing table of refs, ~0 is empty
+    int internedCount;
+    QVector<Mark> notes;
+    double estimate;
+    MergeStats merged;
+
+    quint32 store(const char *line, int length);
+};
+
+#endif // GCODESTORE_H
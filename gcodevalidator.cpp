@@ -0,0 +1,284 @@
+#include "gcodevalidator.h"
+
+#include <QFile>
+#include <cstring>
+#include <QtConcurrent/QtConcurrent>
+
+static const int chunkSize = 4 << 20; //Bytes per parallel chunk
+static const int maxIssuesPerChunk = 1000;
+
+//Supported command ranges, pairs of first and last code
+static const int marlinG[] = {0,6, 10,12, 17,21, 26,35, 38,38, 42,42, 53,61, 76,76, 80,80, 90,92, 425,425, -1};
+static const int marlinM[] = {0,1, 3,5, 7,12, 16,34, 42,43, 48,48, 73,73, 75,92, 100,129, 140,140, 141,141,
+                              145,145, 149,150, 154,155, 163,164, 165,166, 190,193, 200,209, 211,211,
+                              217,222, 226,226, 240,240, 250,252, 256,256, 260,261, 280,281, 290,290,
+                              300,306, 350,351, 355,355, 360,364, 380,381, 400,402, 403,407, 410,410,
+                              412,413, 420,425, 428,430, 486,486, 500,504, 510,512, 524,524, 540,540,
+                              569,569, 575,575, 600,600, 603,603, 605,605, 665,666, 672,672, 701,702,
+                              710,710, 808,808, 810,810, 851,852, 860,869, 871,871, 876,876, 900,900,
+                              906,919, 928,928, 951,951, 995,995, 997,997, 999,999, -1};
+static const int repetierG[] = {0,4, 10,11, 20,21, 28,33, 90,92, 100,100, 131,135, 201,205, -1};
+static const int repetierM[] = {0,1, 3,8, 17,18, 20,32, 36,36, 42,42, 80,85, 92,92, 99,99, 104,120,
+                                140,140, 143,143, 155,155, 163,164, 170,170, 190,190, 200,209, 220,221,
+                                226,226, 231,233, 251,251, 280,281, 290,290, 300,303, 320,323, 340,340,
+                                350,350, 355,355, 360,360, 400,402, 450,453, 460,460, 500,502, 513,513,
+                                600,602, 604,604, 908,908, 999,999, -1};
+
+static void fillRanges(QBitArray &bits, const int *ranges)
+{
+    bits.resize(1024);
+    for(int i = 0; ranges[i] != -1; i += 2)
+        for(int code = ranges[i]; code <= ranges[i+1]; code++) bits.setBit(code);
+}
+
+void GCodeValidator::fillSupported(Context &context)
+{
+    switch(context.limits.firmware)
+    {
+    case Marlin:
+        fillRanges(context.gcodes, marlinG);
+        fillRanges(context.mcodes, marlinM);
+        break;
+    case Repetier:
+        fillRanges(context.gcodes, repetierG);
+        fillRanges(context.mcodes, repetierM);
+        break;
+    default:
+        break; //Unknown firmware, do not guess
+    }
+}
+
+QList<GCodeValidator::Issue> GCodeValidator::validate(QString filename, Limits limits)
+{
+    QList<Issue> issues;
+    QFile file(filename);
+
+    if(!file.open(QIODevice::ReadOnly) || !file.size()) return issues;
+
+    const char *data = reinterpret_cast<const char*>(file.map(0, file.size()));
+    if(!data) return issues;
+    const char *dataEnd = data + file.size();
+
+    Context context;
+    context.limits = limits;
+    fillSupported(context);
+
+    //Split on line borders
+    QVector<Chunk> chunks;
+    for(const char *p = data; p < dataEnd; )
+    {
+        Chunk chunk;
+        chunk.begin = p;
+        chunk.end = qMin(p + chunkSize, dataEnd);
+        while(chunk.end < dataEnd && chunk.end[-1] != '\n') chunk.end++;
+        chunk.context = &context;
+        chunk.lines = 0;
+        chunk.firstLine = 1;
+        chunks.append(chunk);
+        p = chunk.end;
+    }
+
+    //First pass: line counts and what every chunk does to the modal state
+    QtConcurrent::blockingMap(chunks, scanChunk);
+
+    ModalState state;
+    state.relative = false;
+    state.x.known = state.y.known = false; //Position is unknown until homed or set
+    state.x.value = state.y.value = 0;
+
+    quint64 line = 1;
+    for(int i = 0; i < chunks.size(); i++)
+    {
+        chunks[i].firstLine = line;
+        chunks[i].start = state;
+        line += chunks.at(i).lines;
+        state = combine(state, chunks.at(i));
+    }
+
+    //Second pass: real checks with known starting state
+    QtConcurrent::blockingMap(chunks, checkChunk);
+
+    for(int i = 0; i < chunks.size(); i++) issues.append(chunks.at(i).issues);
+
+    file.unmap((uchar*)data);
+    file.close();
+
+    return issues;
+}
+
+void GCodeValidator::scanChunk(Chunk &chunk)
+{
+    GCodeCommand c;
+    ModalState &fromAbsolute = chunk.exitFromAbsolute;
+    ModalState &fromRelative = chunk.exitFromRelative;
+
+    fromAbsolute.relative = false;
+    fromRelative.relative = true;
+    fromAbsolute.x.known = fromAbsolute.y.known = false;
+    fromAbsolute.x.value = fromAbsolute.y.value = 0;
+    fromRelative.x = fromAbsolute.x;
+    fromRelative.y = fromAbsolute.y;
+
+    for(const char *p = chunk.begin; p < chunk.end; )
+    {
+        const char *eol = static_cast<const char*>(memchr(p, '\n', chunk.end - p));
+        if(!eol) eol = chunk.end;
+
+        if(c.parse(p, eol - p))
+        {
+            apply(fromAbsolute, c);
+            apply(fromRelative, c);
+        }
+
+        chunk.lines++;
+        p = eol + 1;
+    }
+}
+
+void GCodeValidator::checkChunk(Chunk &chunk)
+{
+    const Context &context = *chunk.context;
+    const Limits &limits = context.limits;
+    GCodeCommand c;
+    ModalState state = chunk.start;
+    quint64 line = chunk.firstLine;
+
+    for(const char *p = chunk.begin; p < chunk.end && chunk.issues.size() < maxIssuesPerChunk; line++)
+    {
+        const char *eol = static_cast<const char*>(memchr(p, '\n', chunk.end - p));
+        if(!eol) eol = chunk.end;
+        const char *begin = p;
+        p = eol + 1;
+
+        if(!c.parse(begin, eol - begin)) continue;
+
+        Issue issue;
+        issue.line = line;
+
+        const QBitArray &supported = (c.letter == 'G') ? context.gcodes : context.mcodes;
+        if(c.letter != 'T' && !supported.isEmpty()
+                && (c.code < 0 || c.code >= supported.size() || !supported.testBit(c.code)))
+        {
+            issue.type = UnsupportedCommand;
+            issue.message = QString(QChar(c.letter)) + QString::number(c.code) + " is not supported by the firmware";
+            chunk.issues.append(issue);
+        }
+
+        if(c.letter == 'M' && c.has('S'))
+        {
+            double limit = -1;
+            if(c.code == 104 || c.code == 109) limit = limits.maxExtruder;
+            else if(c.code == 140 || c.code == 190) limit = limits.maxBed;
+
+            if(limit >= 0 && c.value('S') > limit)
+            {
+                issue.type = UnsafeTemperature;
+                issue.message = "Temperature " + QString::number(c.value('S'))
+                        + " is above the limit of " + QString::number(limit);
+                chunk.issues.append(issue);
+            }
+        }
+
+        if(apply(state, c))
+        {
+            const double e = 0.001;
+            if((state.x.known && (state.x.value < -e || state.x.value > limits.bedX + e))
+                    || (state.y.known && (state.y.value < -e || state.y.value > limits.bedY + e)))
+            {
+                issue.type = OutOfBed;
+                issue.message = "Move outside of the bed to X" + QString::number(state.x.value)
+                        + " Y" + QString::number(state.y.value);
+                chunk.issues.append(issue);
+            }
+        }
+    }
+}
+
+bool GCodeValidator::apply(ModalState &state, const GCodeCommand &c)
+{
+    //Returns true if the line is a move
+    if(c.letter != 'G') return false;
+
+    switch(c.code)
+    {
+    case 0:
+    case 1:
+    case 2:
+    case 3:
+        if(!c.has('X') && !c.has('Y')) return false;
+        if(c.has('X'))
+        {
+            if(state.relative) state.x.value += c.value('X');
+            else
+            {
+                state.x.known = true;
+                state.x.value = c.value('X');
+            }
+        }
+        if(c.has('Y'))
+        {
+            if(state.relative) state.y.value += c.value('Y');
+            else
+            {
+                state.y.known = true;
+                state.y.value = c.value('Y');
+            }
+        }
+        return true;
+    case 28:
+    {
+        bool all = !c.has('X') && !c.has('Y') && !c.has('Z');
+        if(all || c.has('X'))
+        {
+            state.x.known = true;
+            state.x.value = 0;
+        }
+        if(all || c.has('Y'))
+        {
+            state.y.known = true;
+            state.y.value = 0;
+        }
+        break;
+    }
+    case 90:
+        state.relative = false;
+        break;
+    case 91:
+        state.relative = true;
+        break;
+    case 92:
+        if(c.has('X') || (!c.has('Y') && !c.has('Z') && !c.has('E')))
+        {
+            state.x.known = true;
+            state.x.value = c.has('X') ? c.value('X') : 0;
+        }
+        if(c.has('Y') || (!c.has('X') && !c.has('Z') && !c.has('E')))
+        {
+            state.y.known = true;
+            state.y.value = c.has('Y') ? c.value('Y') : 0;
+        }
+        break;
+    }
+
+    return false;
+}
+
+GCodeValidator::ModalState GCodeValidator::combine(const ModalState &before, const Chunk &chunk)
+{
+    const ModalState &exit = before.relative ? chunk.exitFromRelative : chunk.exitFromAbsolute;
+    ModalState after = exit;
+
+    //Offsets only make sense on top of a known position
+    if(!exit.x.known)
+    {
+        after.x.known = before.x.known;
+        after.x.value = before.x.value + exit.x.value;
+    }
+    if(!exit.y.known)
+    {
+        after.y.known = before.y.known;
+        after.y.value = before.y.value + exit.y.value;
+    }
+
+    return after;
+}
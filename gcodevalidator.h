@@ -0,0 +1,81 @@
+#ifndef GCODEVALIDATOR_H
+#define GCODEVALIDATOR_H
+
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QBitArray>
+
+#include "repraptor.h"
+#include "gcodecommand.h"
+
+using namespace RepRaptor;
+
+//Checks a G-code file for moves outside of the bed, commands the selected
+//firmware does not know and unsafe temperatures. The file is mapped and
+//split into chunks that are checked in parallel, modal state (G90/G91,
+//position) is carried over chunk borders by a cheap first pass.
+class GCodeValidator
+{
+public:
+    enum IssueType
+    {
+        OutOfBed,
+        UnsupportedCommand,
+        UnsafeTemperature
+    };
+
+    typedef struct
+    {
+        quint64 line; //1-based line number in the file
+        int type;
+        QString message;
+    } Issue;
+
+    typedef struct
+    {
+        int firmware;
+        double bedX, bedY;
+        double maxExtruder, maxBed;
+    } Limits;
+
+    static QList<Issue> validate(QString filename, Limits limits);
+
+protected:
+    typedef struct
+    {
+        bool known; //If false, value is an offset from the chunk start
+        double value;
+    } Axis;
+
+    typedef struct
+    {
+        bool relative;
+        Axis x, y;
+    } ModalState;
+
+    typedef struct
+    {
+        Limits limits;
+        QBitArray gcodes, mcodes; //Supported commands, empty means anything goes
+    } Context;
+
+    typedef struct
+    {
+        const char *begin, *end;
+        const Context *context;
+        quint64 lines;
+        ModalState exitFromAbsolute, exitFromRelative; //First pass, for both incoming modes
+        quint64 firstLine;
+        ModalState start; //Second pass input
+        QList<Issue> issues;
+    } Chunk;
+
+    static void scanChunk(Chunk &chunk);
+    static void checkChunk(Chunk &chunk);
+    static bool apply(ModalState &state, const GCodeCommand &c);
+    static ModalState combine(const ModalState &before, const Chunk &chunk);
+    static void fillSupported(Context &context);
+};
+
+#endif // GCODEVALIDATOR_H
@@ -0,0 +1,149 @@
+#include "jobqueue.h"
+
+#include <string.h>
+
+JobQueue::JobQueue(QObject *parent) :
+    QObject(parent)
+{
+    checksums = false;
+    merging.enabled = false;
+    merging.deviation = 0;
+    merging.maxRate = 0;
+    connect(&loader, SIGNAL(finished()), this, SLOT(loaded()));
+}
+
+JobQueue::~JobQueue()
+{
+    loader.waitForFinished();
+}
+
+GCodeStore JobQueue::loadFile(QString filename, bool checksums, SegmentMerger::Limits merging, QString *error)
+{
+    GCodeStore gcode;
+    QFile file(filename);
+    char buffer[4096];
+    long number = 0;
+
+    if(error) error->clear();
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        if(error) *error = file.errorString();
+        return gcode;
+    }
+
+    SegmentMerger merger(merging);
+    qint64 read;
+    while ((read = file.readLine(buffer, sizeof(buffer))) > 0)
+    {
+        const char *line = buffer;
+        int length = read;
+        number++;
+
+        if(buffer[read-1] != '\n' && !file.atEnd()) //Only a long comment makes a line this long
+        {
+            if(!memchr(buffer, ';', read))
+            {
+                if(error) *error = QString("Line %1 is longer than %2 bytes").arg(number).arg(int(sizeof(buffer)) - 1);
+                return GCodeStore();
+            }
+
+            char rest[4096]; //Rest of the comment, the command before it is still in buffer
+            qint64 skipped;
+            do skipped = file.readLine(rest, sizeof(rest));
+            while(skipped == sizeof(rest) - 1 && rest[skipped-1] != '\n');
+        }
+
+        const char *comment = (const char*)memchr(line, ';', length);
+        if(comment) //Comments are never sent, slicer notes are kept as marks
+        {
+            const char *note = comment + 1;
+            int noteLength = buffer + read - note;
+            while(noteLength > 0 && uchar(note[noteLength-1]) <= ' ') noteLength--;
+            bool layer = noteLength > 6 && !strncmp(note, "LAYER:", 6);
+            bool type = noteLength > 5 && !strncmp(note, "TYPE:", 5);
+            if(layer || type) merger.flush(gcode); //Runs never cross a mark
+            if(layer) gcode.mark(GCodeStore::LayerMark, note + 6, noteLength - 6);
+            else if(type) gcode.mark(GCodeStore::TypeMark, note + 5, noteLength - 5);
+            length = comment - line;
+        }
+        while(length > 0 && uchar(line[0]) <= ' ') { line++; length--; }
+        while(length > 0 && uchar(line[length-1]) <= ' ') length--;
+        if(!length) continue;
+
+        if(merging.enabled) merger.add(gcode, line, length);
+        else gcode.append(line, length);
+    }
+
+    merger.flush(gcode);
+    if(merging.enabled) gcode.setMergeStats(merger.stats());
+    TimeEstimator::estimate(gcode); //On the lines that will be sent
+    gcode.squeeze();
+    if(checksums) return LineEncoder::encode(gcode); //Numbered in parallel once the line count is known
+    return gcode;
+}
+
+void JobQueue::setChecksums(bool checksums)
+{
+    this->checksums = checksums;
+}
+
+void JobQueue::setMerging(SegmentMerger::Limits merging)
+{
+    this->merging = merging;
+}
+
+void JobQueue::append(const QString &filename)
+{
+    pending.append(filename);
+    preload();
+    emit changed();
+}
+
+void JobQueue::clear()
+{
+    pending.clear();
+    next.clear();
+    nextFile.clear();
+    emit changed(); //A running load is dropped when it finishes
+}
+
+QString JobQueue::takeNext(GCodeStore &gcode)
+{
+    if(!isReady()) return QString();
+
+    gcode.clear();
+    gcode.swap(next);
+    nextFile.clear();
+
+    QString filename = pending.takeFirst();
+    preload();
+    emit changed();
+
+    return filename;
+}
+
+void JobQueue::preload()
+{
+    if(pending.isEmpty() || loader.isRunning() || isReady()) return;
+
+    loadingFile = pending.first();
+    loader.setFuture(QtConcurrent::run(JobQueue::loadFile, loadingFile, checksums, merging, &loadError));
+}
+
+void JobQueue::loaded()
+{
+    if(!pending.isEmpty() && loadingFile == pending.first() && !loadError.isEmpty())
+    {
+        pending.removeFirst(); //Printing it would skip lines, the rest of the queue goes on
+        emit loadFailed(loadingFile, loadError);
+        emit changed();
+        preload();
+    }
+    else if(!pending.isEmpty() && loadingFile == pending.first())
+    {
+        next = loader.result();
+        nextFile = loadingFile;
+        emit changed();
+    }
+    else preload(); //Queue changed while loading
+}
@@ -0,0 +1,59 @@
+#ifndef JOBQUEUE_H
+#define JOBQUEUE_H
+
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrent>
+
+#include "gcodestore.h"
+#include "telemetry.h"
+#include "lineencoder.h"
+#include "segmentmerger.h"
+
+//Files waiting to be printed after the current one.
+//The first of them is always loaded in the background,
+//so switching to it does not leave the printer idle.
+class JobQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit JobQueue(QObject *parent = 0);
+    ~JobQueue();
+
+    static GCodeStore loadFile(QString filename, bool checksums, SegmentMerger::Limits merging, QString *error);
+
+    void setChecksums(bool checksums);
+    void setMerging(SegmentMerger::Limits merging);
+    void append(const QString &filename);
+    void clear();
+    inline int size() const { return pending.size(); }
+    inline bool isEmpty() const { return pending.isEmpty(); }
+    inline bool isReady() const { return !pending.isEmpty() && nextFile == pending.first(); }
+    inline QStringList files() const { return pending; }
+    QString takeNext(GCodeStore &gcode);
+
+protected:
+    QStringList pending;
+    QFutureWatcher<GCodeStore> loader;
+    QString loadingFile;
+    QString nextFile;       //File next belongs to
+    GCodeStore next;
+    bool checksums;
+    SegmentMerger::Limits merging;
+    QString loadError;      //Written by the loader, read when it has finished
+
+    void preload();
+
+signals:
+    void changed();
+    void loadFailed(QString filename, QString error);
+
+protected slots:
+    void loaded();
+};
+
+#endif // JOBQUEUE_H
@@ -0,0 +1,101 @@
+#include "latencyprofile.h"
+
+#include <string.h>
+
+LatencyProfile::LatencyProfile()
+{
+    clear();
+}
+
+int LatencyProfile::classify(const char *line, int length)
+{
+    const char *p = line, *end = line + length;
+
+    while(p < end && *p == ' ') p++;
+    if(p < end && (*p == 'N' || *p == 'n')) //Line number of the checksummed mode
+    {
+        p++;
+        while(p < end && *p >= '0' && *p <= '9') p++;
+        while(p < end && *p == ' ') p++;
+    }
+    if(p >= end) return Other;
+
+    char letter = *p++ & ~0x20; //Upper case
+    int code = 0;
+    while(p < end && *p >= '0' && *p <= '9') code = code * 10 + (*p++ - '0');
+
+    if(letter == 'G')
+    {
+        switch(code)
+        {
+        case 0: case 1: return Move;
+        case 2: case 3: return Arc;
+        case 4: return Dwell;
+        case 28: return Home;
+        case 29: case 30: return Probe;
+        default: return OtherG;
+        }
+    }
+    else if(letter == 'M')
+    {
+        switch(code)
+        {
+        case 104: return SetHotend;
+        case 109: return WaitHotend;
+        case 140: return SetBed;
+        case 190: return WaitBed;
+        case 105: return ReportTemp;
+        case 106: case 107: return Fan;
+        case 114: return ReportPosition;
+        case 400: return WaitMoves;
+        default: return OtherM;
+        }
+    }
+    else if(letter == 'T') return ToolChange;
+    else return Other;
+}
+
+QString LatencyProfile::className(int commandClass)
+{
+    static const char *names[ClassCount] =
+    {
+        "G0/G1 move", "G2/G3 arc", "G4 dwell", "G28 home", "G29/G30 probe", "Other G",
+        "M104 set hotend", "M109 wait hotend", "M140 set bed", "M190 wait bed",
+        "M105 temperature", "M106/M107 fan", "M114 position", "M400 wait moves", "Other M",
+        "T tool change", "Other"
+    };
+    return names[commandClass];
+}
+
+void LatencyProfile::record(int commandClass, qint64 nsecs)
+{
+    Histogram &h = histograms[commandClass];
+    qint64 us = qMax<qint64>(0, nsecs / 1000);
+
+    int bucket = 0;
+    for(qint64 v = us; v > 1 && bucket < BucketCount - 1; v >>= 1) bucket++;
+
+    h.count++;
+    h.total += us;
+    h.max = qMax(h.max, us);
+    h.buckets[bucket]++;
+}
+
+void LatencyProfile::clear()
+{
+    memset(histograms, 0, sizeof(histograms));
+}
+
+qint64 LatencyProfile::percentile(int commandClass, double fraction) const
+{
+    const Histogram &h = histograms[commandClass];
+    if(!h.count) return 0;
+
+    quint64 wanted = quint64(h.count * fraction), seen = 0;
+    for(int i = 0; i < BucketCount; i++)
+    {
+        seen += h.buckets[i];
+        if(seen > wanted) return qMin(h.max, (qint64(2) << i) - 1);
+    }
+    return h.max;
+}
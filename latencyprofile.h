@@ -0,0 +1,62 @@
+#ifndef LATENCYPROFILE_H
+#define LATENCYPROFILE_H
+
+#include <QString>
+
+//Time from writing a command to its "ok", kept per command class.
+//Histograms have power of two microsecond buckets, so recording is
+//a few integer operations and memory does not grow.
+//With more than one line in flight the time includes waiting behind
+//the lines sent before it.
+class LatencyProfile
+{
+public:
+    enum CommandClass
+    {
+        Move,           //G0, G1
+        Arc,            //G2, G3
+        Dwell,          //G4
+        Home,           //G28
+        Probe,          //G29, G30
+        OtherG,
+        SetHotend,      //M104
+        WaitHotend,     //M109
+        SetBed,         //M140
+        WaitBed,        //M190
+        ReportTemp,     //M105
+        Fan,            //M106, M107
+        ReportPosition, //M114
+        WaitMoves,      //M400
+        OtherM,
+        ToolChange,     //T
+        Other,
+        ClassCount
+    };
+
+    enum
+    {
+        BucketCount = 28  //Bucket i holds [2^i, 2^(i+1)) us, the last one up to 134 s and above
+    };
+
+    typedef struct
+    {
+        quint64 count;
+        qint64 total, max;  //us
+        quint32 buckets[BucketCount];
+    } Histogram;
+
+    LatencyProfile();
+
+    static int classify(const char *line, int length);
+    static QString className(int commandClass);
+
+    void record(int commandClass, qint64 nsecs);
+    void clear();
+    inline const Histogram &histogram(int commandClass) const { return histograms[commandClass]; }
+    qint64 percentile(int commandClass, double fraction) const; //Upper edge of the bucket, us
+
+protected:
+    Histogram histograms[ClassCount];
+};
+
+#endif // LATENCYPROFILE_H
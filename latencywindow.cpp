@@ -0,0 +1,78 @@
+#include "latencywindow.h"
+#include "ui_latencywindow.h"
+
+LatencyWindow::LatencyWindow(LatencyProfile *profile, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::LatencyWindow)
+{
+    ui->setupUi(this);
+
+    this->profile = profile;
+
+    ui->table->setColumnCount(7);
+    ui->table->setHorizontalHeaderLabels(QStringList() << "Command" << "Count" << "Mean, ms" << "Median, ms"
+                                         << "95%, ms" << "Max, ms" << "Distribution");
+    ui->table->verticalHeader()->hide();
+
+    connect(&refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+    refreshTimer.start(500); //Non-modal, numbers keep coming while printing
+    refresh();
+}
+
+LatencyWindow::~LatencyWindow()
+{
+    delete ui;
+}
+
+void LatencyWindow::refresh()
+{
+    int row = 0;
+
+    for(int c = 0; c < LatencyProfile::ClassCount; c++)
+    {
+        const LatencyProfile::Histogram &h = profile->histogram(c);
+        if(!h.count) continue; //Only classes that were sent
+
+        //One bar per bucket from the first to the last used one
+        int first = 0, last = LatencyProfile::BucketCount - 1;
+        quint32 peak = 0;
+        while(!h.buckets[first]) first++;
+        while(!h.buckets[last]) last--;
+        for(int i = first; i <= last; i++) peak = qMax(peak, h.buckets[i]);
+        QString bars;
+        for(int i = first; i <= last; i++)
+            bars += h.buckets[i] ? QChar(0x2581 + int(h.buckets[i] * 7ull / peak)) : QChar(' ');
+
+        QStringList cells;
+        cells << LatencyProfile::className(c)
+              << QString::number(h.count)
+              << QString::number(h.total / 1000.0 / h.count, 'f', 2)
+              << QString::number(profile->percentile(c, 0.5) / 1000.0, 'f', 2)
+              << QString::number(profile->percentile(c, 0.95) / 1000.0, 'f', 2)
+              << QString::number(h.max / 1000.0, 'f', 2)
+              << QString("%1 ms %2 %3 ms").arg((1 << first) / 1000.0).arg(bars).arg((qint64(2) << last) / 1000.0);
+
+        if(ui->table->rowCount() <= row) ui->table->insertRow(row);
+        for(int i = 0; i < cells.size(); i++)
+        {
+            QTableWidgetItem *item = ui->table->item(row, i);
+            if(!item)
+            {
+                item = new QTableWidgetItem();
+                if(i > 0 && i < 6) item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+                ui->table->setItem(row, i, item);
+            }
+            item->setText(cells.at(i));
+        }
+        row++;
+    }
+
+    ui->table->setRowCount(row);
+    ui->table->resizeColumnsToContents();
+}
+
+void LatencyWindow::on_resetbtn_clicked()
+{
+    profile->clear();
+    refresh();
+}
@@ -0,0 +1,31 @@
+#ifndef LATENCYWINDOW_H
+#define LATENCYWINDOW_H
+
+#include <QDialog>
+#include <QTimer>
+
+#include "latencyprofile.h"
+
+namespace Ui {
+class LatencyWindow;
+}
+
+class LatencyWindow : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit LatencyWindow(LatencyProfile *profile, QWidget *parent = 0);
+    ~LatencyWindow();
+
+private:
+    Ui::LatencyWindow *ui;
+    LatencyProfile *profile;
+    QTimer refreshTimer;
+
+private slots:
+    void refresh();
+    void on_resetbtn_clicked();
+};
+
+#endif // LATENCYWINDOW_H
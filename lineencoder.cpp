@@ -0,0 +1,168 @@
+#include "lineencoder.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LINEENCODER_X86
+#include <immintrin.h>
+#endif
+
+static const int minChunkLines = 64 * 1024;
+
+static inline uchar fold(quint64 v)
+{
+    v ^= v >> 32;
+    v ^= v >> 16;
+    v ^= v >> 8;
+    return uchar(v);
+}
+
+//XOR is bytewise, so wider words can be folded together first
+static uchar xorScalar(const char *data, int length)
+{
+    quint64 words = 0;
+    int i = 0;
+    for(; i + 8 <= length; i += 8)
+    {
+        quint64 w;
+        memcpy(&w, data + i, 8);
+        words ^= w;
+    }
+
+    uchar cs = fold(words);
+    for(; i < length; i++) cs ^= data[i];
+    return cs;
+}
+
+#ifdef LINEENCODER_X86
+__attribute__((target("sse2")))
+static uchar xorSSE2(const char *data, int length)
+{
+    __m128i acc = _mm_setzero_si128();
+    int i = 0;
+    for(; i + 16 <= length; i += 16)
+        acc = _mm_xor_si128(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+
+    quint64 lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    return fold(lanes[0] ^ lanes[1]) ^ xorScalar(data + i, length - i);
+}
+
+__attribute__((target("avx2")))
+static uchar xorAVX2(const char *data, int length)
+{
+    __m256i acc = _mm256_setzero_si256();
+    int i = 0;
+    for(; i + 32 <= length; i += 32)
+        acc = _mm256_xor_si256(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+
+    __m128i half = _mm_xor_si128(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    quint64 lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), half);
+    return fold(lanes[0] ^ lanes[1]) ^ xorSSE2(data + i, length - i);
+}
+#endif
+
+typedef uchar (*XorFunction)(const char *data, int length);
+
+static XorFunction pickXor()
+{
+#ifdef LINEENCODER_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) return xorAVX2;
+    if(__builtin_cpu_supports("sse2")) return xorSSE2;
+#endif
+    return xorScalar;
+}
+
+static const XorFunction xorBytes = pickXor();
+
+uchar LineEncoder::checksum(const char *data, int length)
+{
+    return xorBytes(data, length);
+}
+
+int LineEncoder::formatNumber(char *out, quint32 number)
+{
+    //Two digits per division
+    static const char pairs[] =
+        "0001020304050607080910111213141516171819"
+        "2021222324252627282930313233343536373839"
+        "4041424344454647484950515253545556575859"
+        "6061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    char buffer[10];
+    char *p = buffer + sizeof(buffer);
+
+    while(number >= 100)
+    {
+        const char *pair = pairs + (number % 100) * 2;
+        number /= 100;
+        *--p = pair[1];
+        *--p = pair[0];
+    }
+    if(number >= 10)
+    {
+        *--p = pairs[number * 2 + 1];
+        *--p = pairs[number * 2];
+    }
+    else *--p = '0' + number;
+
+    int length = buffer + sizeof(buffer) - p;
+    memcpy(out, p, length);
+    return length;
+}
+
+int LineEncoder::encodeLine(char *out, quint32 number, const char *line, int length)
+{
+    //Checksum algorithm from RepRap wiki, XOR of everything before '*'
+    char *p = out;
+    *p++ = 'N';
+    p += formatNumber(p, number);
+    *p++ = ' ';
+    uchar cs = checksum(out, p - out) ^ checksum(line, length);
+    memcpy(p, line, length);
+    p += length;
+    *p++ = '*';
+    p += formatNumber(p, cs);
+    return p - out;
+}
+
+void LineEncoder::encodeChunk(Chunk &chunk)
+{
+    char buffer[4200]; //Longest stored line plus number and checksum
+
+    for(int i = chunk.first; i < chunk.first + chunk.count; i++)
+    {
+        const char *line = chunk.plain->line(i);
+        int length = chunk.plain->length(i);
+        chunk.numbered.appendUnique(buffer, encodeLine(buffer, i + 1, line, length)); //After M110 N0 firmware expects N1
+    }
+    chunk.numbered.squeeze();
+}
+
+GCodeStore LineEncoder::encode(const GCodeStore &plain)
+{
+    int threads = qMax(1, QThread::idealThreadCount());
+    int chunkLines = qMax(minChunkLines, plain.size() / threads + 1);
+
+    QVector<Chunk> chunks;
+    for(int first = 0; first < plain.size(); first += chunkLines)
+    {
+        Chunk chunk;
+        chunk.plain = &plain;
+        chunk.first = first;
+        chunk.count = qMin(chunkLines, plain.size() - first);
+        chunks.append(chunk);
+    }
+
+    QtConcurrent::blockingMap(chunks, encodeChunk);
+
+    GCodeStore numbered;
+    for(int i = 0; i < chunks.size(); i++) numbered.append(chunks.at(i).numbered);
+    numbered.setMarks(plain.marks());
+    numbered.setDuration(plain.duration());
+    numbered.setMergeStats(plain.mergeStats());
+    numbered.squeeze();
+    return numbered;
+}
@@ -0,0 +1,33 @@
+#ifndef LINEENCODER_H
+#define LINEENCODER_H
+
+#include <QtGlobal>
+#include <QVector>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+
+#include "gcodestore.h"
+
+//Turns a file into "N<n> line*checksum" lines for the checksummed
+//sending mode. Chunks of the file are numbered in parallel, the XOR
+//checksum uses AVX2 or SSE2 when the CPU has it, picked at runtime.
+class LineEncoder
+{
+public:
+    static GCodeStore encode(const GCodeStore &plain);
+    static int encodeLine(char *out, quint32 number, const char *line, int length);
+    static uchar checksum(const char *data, int length);
+    static int formatNumber(char *out, quint32 number);
+
+protected:
+    typedef struct
+    {
+        const GCodeStore *plain;
+        int first, count;
+        GCodeStore numbered;
+    } Chunk;
+
+    static void encodeChunk(Chunk &chunk);
+};
+
+#endif // LINEENCODER_H
@@ -0,0 +1,248 @@
+#include "linkprobe.h"
+
+#include <QtAlgorithms>
+
+static const char probeLine[] = "G4 P0\n"; //Acked right away, moves nothing
+//Same command padded with a comment to the length of a checksummed G1 line,
+//so bursts measure the link with the bytes real file lines carry
+static const char burstLine[] = "G4 P0 ;-------------------------------------\n";
+
+LinkProbe::LinkProbe(QSerialPort *port, QObject *parent) :
+    QObject(parent)
+{
+    this->port = port;
+    stage = Idle;
+    timer.setSingleShot(true);
+
+    connect(&timer, SIGNAL(timeout()), this, SLOT(timeout()));
+}
+
+LinkProbe::~LinkProbe()
+{
+
+}
+
+void LinkProbe::start(const QList<qint32> &bauds)
+{
+    this->bauds = bauds;
+    baudIndex = 0;
+
+    r.baud = 0;
+    r.firmware = OtherFirmware;
+    r.firmwareName.clear();
+    r.capabilities.clear();
+    r.latency = -1;
+    r.rate = 0;
+    r.window = 1;
+
+    connect(port, SIGNAL(readyRead()), this, SLOT(readPort()));
+    stage = Identify;
+    tryBaud();
+}
+
+void LinkProbe::stop()
+{
+    if(stage == Idle) return;
+
+    timer.stop();
+    disconnect(port, SIGNAL(readyRead()), this, SLOT(readPort()));
+    stage = Idle;
+}
+
+void LinkProbe::finish(bool ok)
+{
+    stop();
+    emit finished(ok);
+}
+
+bool LinkProbe::isText(const QByteArray &line) const
+{
+    for(int i = 0; i < line.size(); i++)
+    {
+        uchar c = line.at(i);
+        if((c < 0x20 || c > 0x7e) && c != '\t' && c != '\r' && c != '\n') return false;
+    }
+    return true;
+}
+
+void LinkProbe::tryBaud()
+{
+    if(baudIndex >= bauds.size())
+    {
+        finish(false);
+        return;
+    }
+
+    port->setBaudRate(bauds.at(baudIndex));
+    port->clear();
+
+    tries = 0;
+    garbage = 0;
+    identified = false;
+    r.capabilities.clear();
+
+    port->write("\nM115\n"); //Newline first ends whatever the firmware got before
+    timer.start(IdentifyTimeout);
+}
+
+void LinkProbe::settle(Stage next)
+{
+    //Answers to repeated M115 or a failed burst may still be on the way
+    stage = Settle;
+    afterSettle = next;
+    timer.start(200);
+}
+
+void LinkProbe::ping()
+{
+    port->write(probeLine);
+    clock.start();
+    timer.start(1000);
+}
+
+void LinkProbe::startBurst()
+{
+    stage = Throughput;
+    sent = 0;
+    acked = 0;
+    clock.start();
+    fillBurst();
+    timer.start(2000);
+}
+
+void LinkProbe::fillBurst()
+{
+    while(sent - acked < window && sent < BurstLines)
+    {
+        port->write(burstLine);
+        sent++;
+    }
+}
+
+void LinkProbe::timeout()
+{
+    switch(stage)
+    {
+    case Identify:
+        if(++tries < IdentifyTries)
+        {
+            port->write("M115\n");
+            timer.start(IdentifyTimeout);
+        }
+        else
+        {
+            baudIndex++;
+            tryBaud();
+        }
+        break;
+    case Settle:
+        port->clear(QSerialPort::Input);
+        if(afterSettle == Latency)
+        {
+            stage = Latency;
+            pings.clear();
+            ping();
+        }
+        else startBurst();
+        break;
+    case Latency: //Answers M115 but not G4, keep the safe defaults
+    case Throughput: //Lines got lost, the last good window stays
+        finish(true);
+        break;
+    case Idle:
+        break;
+    }
+}
+
+void LinkProbe::readPort()
+{
+    while(stage != Idle && port->canReadLine())
+    {
+        QByteArray line = port->readLine();
+
+        if(stage == Settle) continue;
+
+        if(!isText(line))
+        {
+            if(stage == Identify && ++garbage > 2) //Wrong baud rate, do not wait for the timeout
+            {
+                baudIndex++;
+                tryBaud();
+                return;
+            }
+            continue;
+        }
+
+        line = line.trimmed();
+
+        if(stage == Identify)
+        {
+            int name = line.indexOf("FIRMWARE_NAME:");
+            if(name != -1)
+            {
+                QString info = QString(line.mid(name + 14));
+                QRegExp nextKey(" [A-Z_]+:");
+                int end = nextKey.indexIn(info);
+
+                r.firmwareName = (end == -1 ? info : info.left(end)).trimmed();
+                if(r.firmwareName.contains("Marlin", Qt::CaseInsensitive)) r.firmware = Marlin;
+                else if(r.firmwareName.contains("Repetier", Qt::CaseInsensitive)) r.firmware = Repetier;
+                else r.firmware = OtherFirmware;
+                identified = true;
+            }
+            else if(line.startsWith("Cap:")) r.capabilities.append(QString(line.mid(4)));
+            else if(line.startsWith("start")) //Board was reset by opening the port, ask again
+            {
+                port->write("M115\n");
+                timer.start(IdentifyTimeout);
+            }
+            else if(line.startsWith("ok"))
+            {
+                r.baud = bauds.at(baudIndex);
+                settle(Latency);
+            }
+        }
+        else if(stage == Latency && line.startsWith("ok"))
+        {
+            pings.append(clock.nsecsElapsed() / 1000000.0);
+            if(pings.size() < Pings) ping();
+            else
+            {
+                qSort(pings);
+                r.latency = pings.at(pings.size() / 2);
+                r.window = 1;
+                bestRate = 0; //Short pings say nothing about the rate, window 1 is measured too
+                window = 1;
+                startBurst();
+            }
+        }
+        else if(stage == Throughput)
+        {
+            if(line.startsWith("Error") || line.startsWith("Resend") || line.startsWith("rs"))
+            {
+                finish(true); //Window overflowed the firmware buffer
+                return;
+            }
+            else if(line.startsWith("ok"))
+            {
+                acked++;
+                if(acked < BurstLines) fillBurst();
+                else
+                {
+                    double rate = BurstLines / (clock.nsecsElapsed() / 1000000000.0);
+
+                    if(rate > bestRate * 1.1) //Deeper windows only when they pay off
+                    {
+                        bestRate = rate;
+                        r.rate = rate;
+                        r.window = window;
+                    }
+
+                    window *= 2;
+                    if(window > MaxWindow) finish(true);
+                    else settle(Throughput); //Let the queue empty before the next burst
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef LINKPROBE_H
+#define LINKPROBE_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QVector>
+#include <QtSerialPort/QtSerialPort>
+
+#include "repraptor.h"
+
+using namespace RepRaptor;
+
+//Runs on a freshly opened port before the sender takes it over.
+//Finds a baud rate the firmware answers M115 on, reads the firmware
+//name and capabilities, then times G4 P0 round trips, and bursts of
+//G4 P0 padded to file line length to choose how many lines may be in flight.
+class LinkProbe : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef struct
+    {
+        qint32 baud;
+        int firmware;
+        QString firmwareName;
+        QStringList capabilities; //Like "AUTOREPORT_TEMP:1"
+        double latency;           //Median round trip in ms, -1 if not measured
+        double rate;              //File sized lines per second over the link with the chosen window, 0 if not measured
+        int window;
+    } Result;
+
+    explicit LinkProbe(QSerialPort *port, QObject *parent = 0);
+    ~LinkProbe();
+
+    void start(const QList<qint32> &bauds);
+    void stop();
+    inline bool isRunning() const { return stage != Idle; }
+    inline const Result &result() const { return r; }
+
+protected:
+    enum Stage
+    {
+        Idle,
+        Identify,
+        Settle,
+        Latency,
+        Throughput
+    };
+
+    enum
+    {
+        IdentifyTries = 3,
+        IdentifyTimeout = 800,
+        Pings = 8,
+        BurstLines = 32,
+        MaxWindow = 4 //Marlin queues 4 commands by default
+    };
+
+    QSerialPort *port;
+    QTimer timer;
+    QElapsedTimer clock;
+    Stage stage;
+    Stage afterSettle;
+    QList<qint32> bauds;
+    int baudIndex;
+    int tries;
+    int garbage;
+    bool identified;
+    QVector<double> pings;
+    int window;
+    int sent, acked;
+    double bestRate;
+    Result r;
+
+    void tryBaud();
+    void settle(Stage next);
+    void ping();
+    void startBurst();
+    void fillBurst();
+    void finish(bool ok);
+    bool isText(const QByteArray &line) const;
+
+signals:
+    void finished(bool ok);
+
+protected slots:
+    void readPort();
+    void timeout();
+};
+
+#endif // LINKPROBE_H
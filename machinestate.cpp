@@ -0,0 +1,126 @@
+#include "machinestate.h"
+
+MachineState::MachineState()
+{
+    reset();
+}
+
+void MachineState::reset()
+{
+    x = y = z = e = 0;
+    feedrate = 0;
+    absolute = true;
+    absoluteE = true;
+    homed = false;
+    fan = 0;
+    tool = 0;
+    extruderTarget = bedTarget = 0;
+    extruderTemp = bedTemp = 0;
+    speedFactor = flowFactor = 100;
+    unit = 1;
+}
+
+void MachineState::update(const char *line, int length)
+{
+    if(!command.parse(line, length)) return;
+
+    if(command.letter == 'G')
+    {
+        switch(command.code)
+        {
+        case 0:
+        case 1:
+        case 2:
+        case 3: //Arcs end where X/Y say, center does not matter here
+            if(command.has('X')) x = (absolute ? 0 : x) + command.value('X') * unit;
+            if(command.has('Y')) y = (absolute ? 0 : y) + command.value('Y') * unit;
+            if(command.has('Z')) z = (absolute ? 0 : z) + command.value('Z') * unit;
+            if(command.has('E')) e = (absoluteE ? 0 : e) + command.value('E') * unit;
+            if(command.has('F')) feedrate = command.value('F') * unit;
+            break;
+        case 20:
+            unit = 25.4;
+            break;
+        case 21:
+            unit = 1;
+            break;
+        case 28:
+        {
+            bool all = !command.has('X') && !command.has('Y') && !command.has('Z');
+            if(all || command.has('X')) x = 0;
+            if(all || command.has('Y')) y = 0;
+            if(all || command.has('Z')) z = 0;
+            if(all) homed = true;
+            break;
+        }
+        case 90:
+            absolute = true;
+            absoluteE = true;
+            break;
+        case 91:
+            absolute = false;
+            absoluteE = false;
+            break;
+        case 92:
+        {
+            bool all = !command.has('X') && !command.has('Y') && !command.has('Z') && !command.has('E');
+            if(all || command.has('X')) x = command.has('X') ? command.value('X') * unit : 0;
+            if(all || command.has('Y')) y = command.has('Y') ? command.value('Y') * unit : 0;
+            if(all || command.has('Z')) z = command.has('Z') ? command.value('Z') * unit : 0;
+            if(all || command.has('E')) e = command.has('E') ? command.value('E') * unit : 0;
+            if(command.has('X') && command.has('Y') && command.has('Z')) homed = true;
+            break;
+        }
+        }
+    }
+    else if(command.letter == 'M')
+    {
+        switch(command.code)
+        {
+        case 82:
+            absoluteE = true;
+            break;
+        case 83:
+            absoluteE = false;
+            break;
+        case 84:
+        case 18:
+            homed = false; //Steppers off, the carriage can be moved by hand
+            break;
+        case 104:
+        case 109:
+            if(command.has('S')) extruderTarget = command.value('S');
+            break;
+        case 140:
+        case 190:
+            if(command.has('S')) bedTarget = command.value('S');
+            break;
+        case 106:
+            fan = command.has('S') ? qBound(0, int(command.value('S')), 255) : 255;
+            break;
+        case 107:
+            fan = 0;
+            break;
+        case 220:
+            if(command.has('S')) speedFactor = int(command.value('S'));
+            break;
+        case 221:
+            if(command.has('S')) flowFactor = int(command.value('S'));
+            break;
+        }
+    }
+    else if(command.letter == 'T') tool = command.code;
+}
+
+void MachineState::setTemperature(double extruder, double bed)
+{
+    extruderTemp = extruder;
+    bedTemp = bed;
+}
+
+QString MachineState::positionString() const
+{
+    return QString("X:%1 Y:%2 Z:%3 E:%4")
+            .arg(x, 0, 'f', 2).arg(y, 0, 'f', 2).arg(z, 0, 'f', 2).arg(e, 0, 'f', 2)
+            + (homed ? "" : " ?");
+}
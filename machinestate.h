@@ -0,0 +1,40 @@
+#ifndef MACHINESTATE_H
+#define MACHINESTATE_H
+
+#include <QString>
+#include <QByteArray>
+
+#include "gcodecommand.h"
+
+//Host side copy of the printer state, updated from every line the
+//firmware has acknowledged. Coordinates are the ones G-code works in,
+//so they are valid targets for moves after G92 offsets too.
+class MachineState
+{
+public:
+    MachineState();
+
+    double x, y, z, e;
+    double feedrate;        //mm/min of the last move
+    bool absolute;          //G90/G91
+    bool absoluteE;         //M82/M83
+    bool homed;             //Position is known (G28 or G92 on all axes)
+    int fan;                //0-255
+    int tool;
+    double extruderTarget, bedTarget;
+    double extruderTemp, bedTemp;
+    int speedFactor, flowFactor; //M220/M221 percents
+
+    void reset();
+    void update(const char *line, int length);
+    inline void update(const QByteArray &line) { update(line.constData(), line.size()); }
+    void setTemperature(double extruder, double bed);
+
+    QString positionString() const;
+
+protected:
+    GCodeCommand command;
+    double unit;            //1 for G21, 25.4 for G20
+};
+
+#endif // MACHINESTATE_H
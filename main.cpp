@@ -1,9 +1,15 @@
 #include "mainwindow.h"
+#include "startupprofile.h"
 #include <QApplication>
+#include <string.h>
 
 int main(int argc, char *argv[])
 {
+    for(int i = 1; i < argc; i++)
+        if(!strcmp(argv[i], "--startup-profile")) StartupProfile::enable();
+
     QApplication a(argc, argv);
+    StartupProfile::mark("application created");
 
     QCoreApplication::setOrganizationName("NeoTheFox");
     QCoreApplication::setOrganizationDomain("https://github.com/NeoTheFox");
@@ -12,7 +18,9 @@ int main(int argc, char *argv[])
     QThread::currentThread()->setPriority(QThread::HighestPriority);
 
     MainWindow w;
+    StartupProfile::mark("main window constructed");
     w.show();
+    StartupProfile::mark("main window shown");
 
     return a.exec();
 }
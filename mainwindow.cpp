@@ -16,6 +16,7 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->consoleGroup->setDisabled(true);
     ui->pauseBtn->setDisabled(true);
     ui->actionPrint_from_SD->setDisabled(true);
+    ui->actionUpload_to_SD->setDisabled(true);
     ui->actionSet_SD_printing_mode->setDisabled(true);
     ui->actionEEPROM_editor->setDisabled(true);
     ui->extruderlcd->setPalette(Qt::red);
@@ -25,6 +26,7 @@ MainWindow::MainWindow(QWidget *parent) :
     recentMenu->setTitle("Recent files");
     ui->menuFile->insertMenu(ui->actionSettings, recentMenu);
     ui->menuFile->insertSeparator(ui->actionSettings);
+    connect(recentMenu, SIGNAL(aboutToShow()), this, SLOT(updateRecent())); //Built when first needed
 
     //Init baudrate combobox
     ui->baudbox->addItem(QString::number(4800));
@@ -35,82 +37,149 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->baudbox->addItem(QString::number(250000));
     ui->baudbox->addItem(QString::number(460800));
     ui->baudbox->addItem(QString::number(500000));
+    ui->baudbox->addItem("Auto"); //Last, so stored indexes keep their meaning
 
-    //Restore settings
+    //Restore what is seen in the first frame, the rest is read in startDeferred()
     firstrun = !settings.value("core/firstrun").toBool(); //firstrun is inverted!
     ui->baudbox->setCurrentIndex(settings.value("printer/baudrateindex", 2).toInt());
     checkingTemperature = settings.value("core/checktemperature", 0).toBool();
     ui->checktemp->setChecked(checkingTemperature);
     ui->etmpspin->setValue(settings.value("user/extrudertemp", 210).toInt());
     ui->btmpspin->setValue(settings.value("user/bedtemp", 60).toInt());
-    echo = settings.value("core/echo", 0).toBool();
-    autolock = settings.value("core/lockcontrols", 0).toBool();
-    sendingChecksum = settings.value("core/checksums", 0).toBool();
-    chekingSDStatus = settings.value("core/checksdstatus", 1).toBool();
-    firmware = settings.value("printer/firmware", OtherFirmware).toInt();
-    statusTimer.setInterval(settings.value("core/statusinterval", 3000).toInt());
-    sendTimer.setInterval(settings.value("core/senderinterval", 2).toInt());
-    int size = settings.beginReadArray("user/recentfiles");
-    for(int i = 0; i < size; ++i)
-    {
-        settings.setArrayIndex(i);
-        recentFiles.append(settings.value("user/file").toString());
-    }
-    settings.endArray();
+    terminalQueue.reserve(1024);
 
     //Init values
     sending = false;
     paused = false;
     readingFiles = false;
     sdprinting = false;
+    uploading = false;
+    verifyingUpload = false;
+    autoreportTemperature = false;
+    autoreportSD = false;
+    parking = false;
+    parked = false;
+    reconnecting = false;
+    resyncing = false;
+    resumeAfterReconnect = false;
+    lostBaud = 0;
     sdBytes = 0;
     currentLine = 0;
-    readyRecieve = 1;
+    ackedLine = 0;
+    jobNumber = 0;
+    inFlight.setCapacity(1024); //Far more than any window, acks never wrap
+#ifdef ALLOCATION_COUNTER
+    sendAllocations = 0;
+#endif
     lastRecieved = 0;
     userHistoryPos = 0;
     userHistory.append("");
 
-    //Update serial ports
-    serialupdate();
+    recentLoaded = false;
 
     //Internal signal-slots
     connect(&printer, SIGNAL(error(QSerialPort::SerialPortError)), this, SLOT(serialError(QSerialPort::SerialPortError)));
     connect(&printer, SIGNAL(readyRead()), this, SLOT(readSerial()));
     connect(&statusTimer, SIGNAL(timeout()), this, SLOT(checkStatus()));
+    connect(&stateTimer, SIGNAL(timeout()), this, SLOT(updateMachineState()));
+    connect(&reconnectTimer, SIGNAL(timeout()), this, SLOT(tryReconnect()));
+    connect(&resyncTimer, SIGNAL(timeout()), this, SLOT(resyncTimeout()));
+    connect(&terminalTimer, SIGNAL(timeout()), this, SLOT(flushTerminal()));
+    reconnectTimer.setInterval(50);
+    resyncTimer.setSingleShot(true);
     connect(&sendTimer, SIGNAL(timeout()), this, SLOT(sendNext()));
     connect(&progressSDTimer, SIGNAL(timeout()), this, SLOT(checkSDStatus()));
     connect(this, SIGNAL(eepromReady()), this, SLOT(openEEPROMeditor()));
+    connect(&toolpathWatcher, SIGNAL(finished()), this, SLOT(toolpathReady()));
+    connect(&validatorWatcher, SIGNAL(finished()), this, SLOT(validationDone()));
+    connect(&jobQueue, SIGNAL(changed()), this, SLOT(jobQueueChanged()));
+    connect(&jobQueue, SIGNAL(loadFailed(QString,QString)), this, SLOT(jobLoadFailed(QString,QString)));
+    linkProbe = new LinkProbe(&printer, this);
+    connect(linkProbe, &LinkProbe::finished, this, &MainWindow::probeFinished);
 
     //Parser thread signal-slots and init
     qRegisterMetaType<TemperatureReadings>("TemperatureReadings");
     qRegisterMetaType<SDProgress>("SDProgress");
+    qRegisterMetaType<SDFile>("SDFile");
+    qRegisterMetaType<EEPROMSetting>("EEPROMSetting");
     parser = new Parser();
     parserThread = new QThread();
     parser->moveToThread(parserThread);
     connect(parserThread, &QThread::finished, parser, &QObject::deleteLater);
     connect(this, &MainWindow::recievedData, parser, &Parser::parse);
     connect(this, &MainWindow::startedReadingEEPROM, parser, &Parser::setEEPROMReadingMode);
+    connect(this, &MainWindow::firmwareDetected, parser, &Parser::setFirmware);
     connect(parser, &Parser::recievedTemperature, this, &MainWindow::updateTemperature);
     connect(parser, &Parser::recievedOkNum, this, &MainWindow::recievedOkNum);
     connect(parser, &Parser::recievedOkWait, this, &MainWindow::recievedWait);
-    connect(parser, &Parser::recievedSDFilesList, this, &MainWindow::initSDprinting);
-    connect(parser, &Parser::recievedEEPROMLine, this, &MainWindow::EEPROMSettingRecieved);
+    connect(parser, &Parser::recievedSDFilesBegin, this, &MainWindow::initSDprinting);
+    connect(parser, &Parser::recievedSDFile, &sdFiles, &SDFileModel::append);
+    connect(parser, &Parser::recievedSDFilesEnd, this, &MainWindow::sdListingFinished);
+    connect(parser, &Parser::recievedEEPROMSetting, &eepromSettings, &EEPROMModel::append);
     connect(parser, &Parser::recievingEEPROMDone, this, &MainWindow::openEEPROMeditor);
     connect(parser, &Parser::recievedError, this, &MainWindow::recievedError);
     connect(parser, &Parser::recievedSDDone, this, &MainWindow::recievedSDDone);
-    connect(parser, &Parser::recievedResend, this, &MainWindow::recievedResend);
     connect(parser, &Parser::recievedSDUpdate, this, &MainWindow::updateSDStatus);
+    connect(parser, &Parser::recievedCapability, this, &MainWindow::recievedCapability);
     parserThread->start();
 
+    //Control socket for automation
+    connect(&controlServer, &ControlServer::injectRequested, this, &MainWindow::remoteInject);
+    connect(&controlServer, &ControlServer::openRequested, this, &MainWindow::remoteOpen);
+    connect(&controlServer, &ControlServer::startRequested, this, &MainWindow::remoteStart);
+    connect(&controlServer, &ControlServer::pauseRequested, this, &MainWindow::remotePause);
+    connect(&controlServer, &ControlServer::stopRequested, this, &MainWindow::remoteStop);
+    connect(&portWatcher, SIGNAL(portsChanged()), this, SLOT(portsChanged()));
+    connect(&portWatcher, &PortWatcher::portArrived, this, &MainWindow::portArrived);
+
+    //Everything else waits until the window is on screen
+    QTimer::singleShot(0, this, SLOT(startDeferred()));
+}
+
+void MainWindow::startDeferred()
+{
+    StartupProfile::mark("event loop running");
+
+    //Restore settings, nothing reads these before the event loop runs
+    echo = settings.value("core/echo", 0).toBool();
+    autolock = settings.value("core/lockcontrols", 0).toBool();
+    sendingChecksum = settings.value("core/checksums", 0).toBool();
+    chekingSDStatus = settings.value("core/checksdstatus", 1).toBool();
+    firmware = settings.value("printer/firmware", AutoFirmware).toInt();
+    emit firmwareDetected(firmware); //Parser starts out with the same idea of the firmware
+    linkWindow = settings.value("printer/window", 1).toInt();
+    readyRecieve = linkWindow;
+    statusTimer.setInterval(settings.value("core/statusinterval", 3000).toInt());
+    sendTimer.setInterval(settings.value("core/senderinterval", 2).toInt());
+    ui->terminal->document()->setMaximumBlockCount(settings.value("core/terminallines", 5000).toInt());
+    jobQueue.setChecksums(sendingChecksum);
+    jobQueue.setMerging(mergeLimits());
+
+    //Serial ports are listed in the background and watched from now on
+    portWatcher.start();
+
+    if(settings.value("core/controlserver", 0).toBool())
+    {
+        controlServer.connectParser(parser);
+        if(!controlServer.listen(settings.value("core/controlname", "repraptor").toString()))
+            printMsg("Control socket could not be opened\n");
+    }
+
     //Timers init
     statusTimer.start();
     sendTimer.start();
+    stateTimer.start(250);
+    terminalTimer.start(100);
     progressSDTimer.setInterval(2500);
     if(chekingSDStatus) progressSDTimer.start();
     sinceLastTemp.start();
+    linkClock.start();
     sinceLastSDStatus.start();
 
-    updateRecent();
+    if(settings.value("core/wirelog", 0).toBool())
+        wireLogger.startLogging(QStandardPaths::writableLocation(QStandardPaths::DataLocation) + "/wirelog");
+
+    StartupProfile::mark("deferred startup done");
 }
 
 MainWindow::~MainWindow()
@@ -122,77 +191,172 @@ MainWindow::~MainWindow()
     settings.setValue("user/extrudertemp", ui->etmpspin->value());
     settings.setValue("user/bedtemp", ui->btmpspin->value());
 
-    settings.beginWriteArray("user/recentfiles");
-    for(int i = 0; i < recentFiles.size(); ++i)
+    if(recentLoaded) //Otherwise the stored list did not change
     {
-        settings.setArrayIndex(i);
-        settings.setValue("user/file", recentFiles.at(i));
+        settings.beginWriteArray("user/recentfiles");
+        for(int i = 0; i < recentFiles.size(); ++i)
+        {
+            settings.setArrayIndex(i);
+            settings.setValue("user/file", recentFiles.at(i));
+        }
+        settings.endArray();
     }
-    settings.endArray();
 
     //Cleanup what is left
     if(gfile.isOpen()) gfile.close();
     if(printer.isOpen()) printer.close();
+    wireLogger.stopLogging();
     parserThread->quit();
     parserThread->wait();
+    toolpathGeneration.fetchAndAddOrdered(1); //Stop the toolpath build, it uses our members
+    toolpathWatcher.waitForFinished();
 
     delete ui;
 }
 
 void MainWindow::open()
 {
-    sdprinting = false;
     QString filename;
     QDir home;
     filename = QFileDialog::getOpenFileName(this,
                                             "Open GCODE",
                                             home.home().absolutePath(),
                                             "GCODE (*.g *.gco *.gcode *.nc)");
+    if(filename.isEmpty()) return; //Cancelled, keep whatever is loaded
+
+    sdprinting = false;
     gfile.setFileName(filename);
+    loadRecent();
     if(!recentFiles.contains(filename))
     {
         recentFiles.prepend(filename);
         if(recentFiles.size() >= 10) recentFiles.removeLast();
     }
 
-    updateRecent();
     parseFile(filename);
 }
 
-void MainWindow::parseFile(QString filename)
+void MainWindow::parseFile(QString filename, QString *loadError)
 {
+    QString error;
+
     gfile.setFileName(filename);
+    flushTerminal(); //Echoed lines still refer to the old file
+    finishingJob = gcode;
     gcode.clear();
-    if (gfile.open(QIODevice::ReadOnly))
+    jobNumber++;
+    toolpath.clear();
+    if(toolpathwindow) toolpathwindow->setToolpath(0);
+
+    gcode = JobQueue::loadFile(filename, sendingChecksum, mergeLimits(), &error);
+    if(error.isEmpty()) fileLoaded();
+    else if(loadError) *loadError = "Can't load " + filename + ": " + error; //Remote callers get it in the reply
+    else QMessageBox::warning(this, "Open GCODE", "Can't load " + filename + ": " + error);
+}
+
+void MainWindow::fileLoaded()
+{
+    ui->fileBox->setEnabled(true);
+    ui->progressBar->setEnabled(true);
+    if(!sending) ui->sendBtn->setText("Send");
+    jobQueueChanged(); //File name with the queue length
+    ui->filelines->setText(QString::number(gcode.size()) + QString("/0 lines"));
+    GCodeStore::MergeStats merged = gcode.mergeStats();
+    if(merged.before)
+        printMsg(QString("Merged %1 segments into %2, max deviation %3 mm\n")
+                 .arg(merged.before).arg(merged.after).arg(merged.deviation, 0, 'f', 3));
+    telemetry.start(gcode);
+    ui->layerLine->setText(telemetry.layerString());
+    ui->actionExport_print_statistics->setEnabled(!telemetry.isEmpty());
+
+    //Toolpath is built in the background, a newer file cancels the old build
+    int extent = qMax(settings.value("printer/bedx", 200).toInt(), settings.value("printer/bedy", 200).toInt());
+    int generation = toolpathGeneration.fetchAndAddOrdered(1) + 1;
+    toolpathWatcher.setFuture(QtConcurrent::run(Toolpath::fromGCode, gcode, float(extent),
+                                                &toolpathGeneration, generation));
+
+    //Check the file for problems while the user gets ready to print
+    GCodeValidator::Limits limits;
+    limits.firmware = firmware;
+    limits.bedX = settings.value("printer/bedx", 200).toInt();
+    limits.bedY = settings.value("printer/bedy", 200).toInt();
+    limits.maxExtruder = settings.value("printer/maxextrudertemp", 275).toInt();
+    limits.maxBed = settings.value("printer/maxbedtemp", 120).toInt();
+    validationIssues.clear();
+    validatorWatcher.setFuture(QtConcurrent::run(GCodeValidator::validate, gfile.fileName(), limits));
+}
+
+void MainWindow::startNextJob(bool between)
+{
+    if(between) //Queued ahead of the new file's lines
     {
-        QTextStream in(&gfile);
-        int n = 0;
-        while (!in.atEnd())
-        {
-            QString line = in.readLine();
-            if(!line.startsWith(";"))
-            {
-                if(sendingChecksum)
-                {
-                    //Checksum algorithm from RepRap wiki
-                    line = "N"+QString::number(n)+line+"*";
-                    int cs = 0;
-                    for(int i = 0; line.at(i) != '*'; i++) cs = cs ^ line.at(i).toLatin1();
-                    cs &= 0xff;
-                    line += QString::number(cs);
-                    n++;
-                }
-                gcode.append(line);
-            }
+        if(sendingChecksum) injectCommand("M110 N0");
+        injectCommand(settings.value("printer/jobend").toString());
+        injectCommand(settings.value("printer/jobstart").toString());
+    }
 
-        }
-        gfile.close();
-        ui->fileBox->setEnabled(true);
-        ui->progressBar->setEnabled(true);
-        ui->sendBtn->setText("Send");
-        ui->filename->setText(gfile.fileName().split(QDir::separator()).last());
-        ui->filelines->setText(QString::number(gcode.size()) + QString("/0 lines"));
+    if(between && !telemetry.isFinished()) printMsg(telemetry.summary()); //Last acknowledgements are still coming
+    flushTerminal();
+    finishingJob = gcode;
+    gfile.setFileName(jobQueue.takeNext(gcode));
+    temperatureHistory.markPrintStart(QDateTime::currentMSecsSinceEpoch());
+    currentLine = 0;
+    ackedLine = 0;
+    jobNumber++;
+    toolpath.clear();
+    if(toolpathwindow)
+    {
+        toolpathwindow->setToolpath(0);
+        toolpathwindow->setCurrentLine(0);
+    }
+
+    printMsg("Starting job " + gfile.fileName() + "\n");
+    fileLoaded();
+}
+
+void MainWindow::jobQueueChanged()
+{
+    //Queue alone, with nothing opened, makes its first file the current one
+    if(gcode.isEmpty() && !sending && jobQueue.isReady())
+    {
+        startNextJob(false);
+        return;
     }
+
+    QString name = gfile.fileName().split(QDir::separator()).last();
+    if(!jobQueue.isEmpty()) name += " (+" + QString::number(jobQueue.size()) + " queued)";
+    ui->filename->setText(name);
+}
+
+void MainWindow::jobLoadFailed(QString filename, QString error)
+{
+    printMsg("Queued " + filename + " removed, " + error + "\n");
+}
+
+void MainWindow::on_actionQueue_files_triggered()
+{
+    QStringList files = QFileDialog::getOpenFileNames(this,
+                                                      "Queue GCODE",
+                                                      QDir::home().absolutePath(),
+                                                      "GCODE (*.g *.gco *.gcode *.nc)");
+    foreach(const QString &file, files) jobQueue.append(file);
+}
+
+void MainWindow::on_actionClear_job_queue_triggered()
+{
+    jobQueue.clear();
+}
+
+void MainWindow::on_actionExport_print_statistics_triggered()
+{
+    QString filename = QFileDialog::getSaveFileName(this,
+                                                    "Export print statistics",
+                                                    QFileInfo(gfile).completeBaseName() + "-stats.csv",
+                                                    "CSV (*.csv)");
+    if(filename.isEmpty()) return;
+
+    if(!telemetry.exportCsv(filename))
+        QMessageBox::warning(this, "Export print statistics", "Could not write " + filename);
 }
 
 bool MainWindow::sendLine(QString line)
@@ -200,8 +364,19 @@ bool MainWindow::sendLine(QString line)
 
     if(printer.isOpen())
     {
-        if(printer.write(line.toUtf8()+'\n'))
+        QByteArray bytes = line.toUtf8();
+        if(printer.write(bytes+'\n'))
         {
+            SentLine sent;
+            sent.command = uploading ? QByteArray() : bytes; //Uploaded lines go to SD, not to the machine
+            sent.fileText = 0;
+            sent.length = bytes.size();
+            sent.fileLine = -1;
+            sent.job = jobNumber;
+            sent.rejected = false;
+            sent.sentAt = linkClock.nsecsElapsed();
+            inFlight.append(sent);
+            wireLogger.log(WireLogger::Sent, bytes);
             if(echo) printMsg(line + '\n');
             return true;
         }
@@ -211,21 +386,141 @@ bool MainWindow::sendLine(QString line)
 
 }
 
+int MainWindow::sendFileLines(long first, int count)
+{
+    if(!printer.isOpen()) return 0;
+
+    //Lines in the store already end with '\n' and go out as they are.
+    //Lines lying one after another in the store are written at once,
+    //an interned line or a new block starts the next write.
+    const char *run = gcode.line(first);
+    const char *end = run;
+    int lines = 0;
+    while(lines < count && first + lines < gcode.size() && gcode.line(first + lines) == end)
+    {
+        end += gcode.length(first + lines) + 1;
+        lines++;
+    }
+
+    //QSerialPort buffers everything it accepts, so a write is either whole or failed
+    if(!lines || printer.write(run, end - run) != end - run) return 0;
+
+    qint64 now = linkClock.nsecsElapsed();
+    end = run;
+    for(int i = 0; i < lines; i++)
+    {
+        int length = gcode.length(first + i);
+
+        SentLine sent;
+        sent.fileText = uploading ? 0 : end;
+        sent.length = length;
+        sent.fileLine = first + i;
+        sent.job = jobNumber;
+        sent.rejected = false;
+        sent.sentAt = now;
+        inFlight.append(sent);
+        wireLogger.log(WireLogger::Sent, end, length);
+        if(uploading) uploadBytes += uploadSizeOf(end, length);
+
+        end += length + 1;
+    }
+
+    if(echo) echoFileLines(first, lines);
+    return lines;
+}
+
+void MainWindow::updateFileProgress()
+{
+    if(uploading)
+        ui->filelines->setText(QString::number(uploadBytes)
+                               + QString("/")
+                               + QString::number(uploadSize)
+                               + QString(" bytes, ")
+                               + QString::number(uploadBytes / qMax<qint64>(1, uploadTime.elapsed()))
+                               + QString(" kB/s"));
+    else
+        ui->filelines->setText(QString::number(gcode.size())
+                               + QString("/")
+                               + QString::number(currentLine)
+                               + QString(" Lines"));
+    ui->progressBar->setValue(((float)currentLine/gcode.size()) * 100);
+}
+
 void MainWindow::serialupdate()
 {
+    portWatcher.refresh(); //portsChanged() fills the list when it is done
+}
+
+void MainWindow::portsChanged()
+{
+    static bool first = true;
+    if(first) StartupProfile::mark("serial ports listed");
+    first = false;
+
+    QString current = ui->serialBox->currentText();
+    QList<QSerialPortInfo> list = portWatcher.ports();
+
     ui->serialBox->clear();
-    QList<QSerialPortInfo> list = QSerialPortInfo::availablePorts();
     for(int i = 0; i < list.size(); i++)
+    {
         ui->serialBox->addItem(list.at(i).portName());
+        ui->serialBox->setItemData(i, PortWatcher::identity(list.at(i)), Qt::ToolTipRole);
+    }
+    if(ui->serialBox->findText(current) != -1) ui->serialBox->setCurrentText(current); //Keep the choice over hotplug
+}
+
+void MainWindow::portArrived(const QSerialPortInfo &info)
+{
+    if(reconnecting) //The lost printer may be back, do not wait for the next try
+    {
+        tryReconnect();
+        return;
+    }
+
+    if(printer.isOpen() || resyncing || !settings.value("core/autoconnect", 0).toBool()) return;
+    QString id = PortWatcher::uniqueIdentity(info); //VID:PID alone would match every clone of the board
+    if(id.isEmpty() || !settings.value("printer/known").toStringList().contains(id)) return;
+
+    printMsg("Known printer on " + info.portName() + ", connecting\n");
+    ui->serialBox->setCurrentText(info.portName());
+    serialconnect();
+}
+
+void MainWindow::rememberPrinter(const QSerialPortInfo &info)
+{
+    //Most recent first, so a farm host keeps the printers it actually drives
+    QString id = PortWatcher::uniqueIdentity(info);
+    if(id.isEmpty()) return; //Could not be told from other boards when plugged in
+
+    QStringList known = settings.value("printer/known").toStringList();
+    known.removeAll(id);
+    known.prepend(id);
+    while(known.size() > 32) known.removeLast();
+    settings.setValue("printer/known", known);
 }
 
 void MainWindow::serialconnect()
 {
-    userCommands.clear();
+    commandQueue.clear();
+
+    if(reconnecting || resyncing) //Button works as cancel while the printer is being looked for
+    {
+        reconnectTimer.stop();
+        resyncTimer.stop();
+        reconnecting = false;
+        resyncing = false;
+        verifyingUpload = false;
+        if(printer.isOpen()) printer.close();
+        resetAutoreport();
+        inFlight.clear();
+        machineState.reset();
+        setConnectedUi(false);
+        return;
+    }
 
     if(!printer.isOpen())
     {
-        foreach (const QSerialPortInfo &info, QSerialPortInfo::availablePorts())
+        foreach (const QSerialPortInfo &info, portWatcher.ports())
         {
             if(info.portName() == ui->serialBox->currentText())
             {
@@ -238,6 +533,28 @@ void MainWindow::serialconnect()
 
         if(printer.open(QIODevice::ReadWrite))
         {
+            printerIdentity = PortWatcher::uniqueIdentity(printerinfo); //by-path is gone once the board is
+            bool autoBaud = ui->baudbox->currentIndex() == ui->baudbox->count() - 1;
+
+            ui->connectBtn->setText("Disconnect");
+
+            if(autoBaud || settings.value("printer/firmware", AutoFirmware).toInt() == AutoFirmware)
+            {
+                QList<qint32> bauds;
+                if(autoBaud)
+                {
+                    qint32 last = settings.value("printer/lastbaud", 0).toInt();
+                    if(last) bauds.append(last); //Most likely the same printer again
+                    QList<qint32> common;
+                    common << 250000 << 115200 << 230400 << 500000 << 460800 << 128000 << 9600 << 4800;
+                    foreach(qint32 b, common) if(b != last) bauds.append(b);
+                }
+                else bauds.append(ui->baudbox->currentText().toInt());
+
+                printMsg("Probing link...\n");
+                linkProbe->start(bauds);
+                return;
+            }
 
             //Moved here to be compatible with Qt 5.2.1
             switch(ui->baudbox->currentText().toInt())
@@ -259,34 +576,208 @@ void MainWindow::serialconnect()
                 break;
             }
 
-            ui->connectBtn->setText("Disconnect");
-            ui->sendBtn->setDisabled(false);
-            //ui->pauseBtn->setDisabled(false);
-            ui->progressBar->setValue(0);
-            ui->controlBox->setDisabled(false);
-            ui->consoleGroup->setDisabled(false);
-            ui->actionPrint_from_SD->setEnabled(true);
-            ui->actionSet_SD_printing_mode->setEnabled(true);
-            if(firmware == Repetier) ui->actionEEPROM_editor->setDisabled(false);
+            rememberPrinter(printerinfo);
+            linkReady(false);
         }
     }
 
     else if(printer.isOpen())
     {
+        linkProbe->stop();
         printer.close();
+        verifyingUpload = false; //Listing after M29 will not come any more
+        resetAutoreport();
+        inFlight.clear();
+        machineState.reset();
 
-        ui->connectBtn->setText("Connect");
-        ui->sendBtn->setDisabled(true);
-        ui->pauseBtn->setDisabled(true);
         ui->progressBar->setValue(0);
-        ui->controlBox->setDisabled(true);
-        ui->consoleGroup->setDisabled(true);
-        ui->actionPrint_from_SD->setDisabled(true);
-        ui->actionSet_SD_printing_mode->setDisabled(true);
-        ui->actionEEPROM_editor->setDisabled(false);
+        setConnectedUi(false);
      }
 }
 
+void MainWindow::probeFinished(bool ok)
+{
+    const LinkProbe::Result &r = linkProbe->result();
+
+    if(!printer.isOpen()) return;
+
+    if(!ok)
+    {
+        printMsg("Printer did not answer the probe, using the selected settings\n");
+        if(ui->baudbox->currentIndex() != ui->baudbox->count() - 1)
+            printer.setBaudRate(ui->baudbox->currentText().toInt());
+        else printer.setBaudRate(QSerialPort::Baud115200);
+        linkReady(false);
+        return;
+    }
+
+    if(settings.value("printer/firmware", AutoFirmware).toInt() == AutoFirmware)
+    {
+        firmware = r.firmware;
+        emit firmwareDetected(firmware);
+    }
+    linkWindow = r.window;
+    settings.setValue("printer/lastbaud", r.baud);
+    settings.setValue("printer/window", r.window);
+    if(r.rate > 0)
+    {
+        settings.setValue("printer/linkrate", r.rate);
+        jobQueue.setMerging(mergeLimits());
+    }
+
+    printMsg(QString("Connected at %1 baud to %2").arg(r.baud)
+             .arg(r.firmwareName.isEmpty() ? QString("unknown firmware") : r.firmwareName));
+    if(r.latency >= 0)
+        printMsg(QString(", %1 ms round trip, %2 lines/s with %3 in flight")
+                 .arg(r.latency, 0, 'f', 1).arg(r.rate, 0, 'f', 0).arg(r.window));
+    printMsg("\n");
+
+    rememberPrinter(printerinfo);
+    linkReady(true);
+
+    foreach(const QString &cap, r.capabilities)
+    {
+        QStringList tmp = cap.split(':');
+        if(tmp.size() == 2) recievedCapability(tmp.at(0), tmp.at(1).toInt());
+    }
+}
+
+void MainWindow::linkReady(bool probed)
+{
+    readyRecieve = linkWindow;
+
+    ui->progressBar->setValue(0);
+    setConnectedUi(true);
+
+    resetAutoreport();
+    inFlight.clear();
+    machineState.reset();
+    if(!probed) injectCommand("M115"); //Ask for capabilities, autoreport replaces polling if supported
+}
+
+void MainWindow::setConnectedUi(bool connected)
+{
+    ui->connectBtn->setText(connected ? "Disconnect" : "Connect");
+    ui->sendBtn->setEnabled(connected);
+    if(!connected) ui->pauseBtn->setDisabled(true);
+    ui->controlBox->setEnabled(connected);
+    ui->consoleGroup->setEnabled(connected);
+    ui->actionPrint_from_SD->setEnabled(connected);
+    ui->actionUpload_to_SD->setEnabled(connected);
+    ui->actionSet_SD_printing_mode->setEnabled(connected);
+    ui->actionEEPROM_editor->setEnabled(connected && (firmware == Marlin || firmware == Repetier));
+}
+
+void MainWindow::startReconnect()
+{
+    if(!reconnecting && !resyncing) //Lost again while resyncing keeps the first decision
+        resumeAfterReconnect = sending && !paused;
+
+    if(sending) paused = true;
+    reconnecting = true;
+    resyncing = false;
+    resyncTimer.stop();
+    inFlight.clear(); //Unacknowledged lines are sent again from ackedLine
+
+    setConnectedUi(false);
+    ui->connectBtn->setText("Cancel"); //Stops looking for the printer
+
+    printMsg("Connection lost, waiting for the printer to come back\n");
+    reconnectTime.start();
+    reconnectTimer.start();
+}
+
+void MainWindow::tryReconnect()
+{
+    if(reconnectTime.elapsed() > settings.value("core/reconnecttimeout", 30).toInt() * 1000)
+    {
+        reconnectTimer.stop();
+        reconnecting = false;
+        resetAutoreport();
+        machineState.reset();
+        setConnectedUi(false);
+
+        ErrorWindow errorwindow(this, "Printer did not come back");
+        errorwindow.exec();
+        return;
+    }
+
+    foreach(const QSerialPortInfo &info, portWatcher.ports()) //Kept current by the watcher, no rescanning here
+    {
+        //USB may give the printer another device name, so match what identifies the board.
+        //VID:PID alone fits every clone of it, then only the same device name is tried
+        if(!printerIdentity.isEmpty() && PortWatcher::uniqueIdentity(info) != printerIdentity) continue;
+        if(printerIdentity.isEmpty() && info.portName() != lostPort.portName()) continue;
+
+        printer.setPort(info);
+        if(!printer.open(QIODevice::ReadWrite)) continue; //Device node may not be usable yet
+        printer.setBaudRate(lostBaud);
+        printerinfo = info;
+
+        if(printerIdentity.isEmpty() && resumeAfterReconnect)
+        {
+            resumeAfterReconnect = false; //Could be another board of the same kind, the user resumes
+            printMsg("Printer can't be told from others of its kind, print stays paused\n");
+        }
+
+        reconnectTimer.stop();
+        reconnecting = false;
+        resyncing = true;
+
+        //Next line to send is ackedLine, sent as N<ackedLine + 1> like every file line
+        readyRecieve = 0;
+        sendLine("M110 N" + QString::number(ackedLine));
+        resyncTimer.start(3000);
+
+        printMsg("Port reopened after " + QString::number(reconnectTime.elapsed()) + " ms\n");
+        return;
+    }
+}
+
+void MainWindow::finishResync(bool survived)
+{
+    resyncing = false;
+    resyncTimer.stop();
+    readyRecieve = linkWindow;
+    setConnectedUi(true);
+
+    if(survived)
+    {
+        if(sending)
+        {
+            currentLine = ackedLine;
+            ui->pauseBtn->setEnabled(true);
+            if(resumeAfterReconnect) paused = false;
+            printMsg("Printer kept its state, continuing from line " + QString::number(currentLine) + "\n");
+        }
+        return;
+    }
+
+    //Firmware restarted: heaters are off and the position is lost
+    inFlight.clear();
+    resetAutoreport();
+    machineState.reset();
+    injectCommand("M115");
+
+    if(sending)
+    {
+        sending = false;
+        paused = false;
+        ui->sendBtn->setText("Send");
+        ui->pauseBtn->setText("Pause");
+        ui->pauseBtn->setDisabled(true);
+
+        ErrorWindow errorwindow(this, "Printer was reset while reconnecting\nPrint stopped at line "
+                                + QString::number(ackedLine));
+        errorwindow.exec();
+    }
+}
+
+void MainWindow::resyncTimeout()
+{
+    finishResync(false); //No answer means no way to tell what the firmware kept
+}
+
 /////////////////
 //Buttons start//
 /////////////////
@@ -460,8 +951,12 @@ void MainWindow::on_flowbutton_clicked()
 void MainWindow::on_haltbtn_clicked()
 {
     if(sending && !paused)ui->pauseBtn->click();
-    userCommands.clear();
-    injectCommand("M112");
+    commandQueue.clear();
+    parking = false;
+    parked = false;
+    injectCommand("M112", EmergencyLane);
+    inFlight.clear();
+    machineState.reset(); //Firmware is killed, nothing is known anymore
 }
 
 void MainWindow::on_actionPrint_from_SD_triggered()
@@ -471,7 +966,14 @@ void MainWindow::on_actionPrint_from_SD_triggered()
 
 void MainWindow::on_sendBtn_clicked()
 {
-    userCommands.clear();
+    commandQueue.clear();
+    parking = false;
+    parked = false;
+    if(uploading)
+    {
+        abortUpload();
+        return;
+    }
     if(sending && !sdprinting)
     {
         sending = false;
@@ -484,6 +986,9 @@ void MainWindow::on_sendBtn_clicked()
     else if(!sending && !sdprinting)
     {
         sending=true;
+        if(sendingChecksum) injectCommand("M110 N0"); //Sent before line 0, which is N1
+        telemetry.hold(); //Time spent stopped is not printing time
+        temperatureHistory.markPrintStart(QDateTime::currentMSecsSinceEpoch());
         ui->sendBtn->setText("Stop");
         ui->pauseBtn->setText("Pause");
         ui->pauseBtn->setEnabled(true);
@@ -494,6 +999,7 @@ void MainWindow::on_sendBtn_clicked()
     {
         sending = false;
         injectCommand("M24");
+        temperatureHistory.markPrintStart(QDateTime::currentMSecsSinceEpoch());
         injectCommand("M27");
         ui->sendBtn->setText("Start");
         ui->pauseBtn->setText("Pause");
@@ -504,19 +1010,27 @@ void MainWindow::on_sendBtn_clicked()
 
     ui->progressBar->setValue(0);
     currentLine = 0;
+    ackedLine = 0;
+    jobNumber++;
+    if(toolpathwindow) toolpathwindow->setCurrentLine(currentLine);
 }
 
 void MainWindow::on_pauseBtn_clicked()
 {
     if(paused && !sdprinting)
     {
+        if(parked) returnFromPark(); //Queued ahead of the file, streaming goes on after it
+        parking = false;
+        parked = false;
         paused = false;
+        telemetry.hold();
         if(autolock) ui->controlBox->setChecked(false);
         ui->pauseBtn->setText("Pause");
     }
     else if(!paused && !sdprinting)
     {
         paused = true;
+        parking = !uploading && settings.value("printer/smartpause", 1).toBool();
         if(autolock) ui->controlBox->setChecked(true);
         ui->pauseBtn->setText("Resume");
     }
@@ -536,32 +1050,127 @@ void MainWindow::on_releasebtn_clicked()
 
 void MainWindow::readSerial()
 {
-    if(printer.canReadLine()) //Check if full line in buffer
+    if(linkProbe->isRunning()) return; //Port belongs to the probe for now
+
+    while(printer.canReadLine()) //Several answers often come in one chunk
     {
         QByteArray data = printer.readLine(); //Read the line
+        wireLogger.log(WireLogger::Recieved, data);
 
         emit recievedData(data); //Send data to parser thread
 
-        if(data.startsWith("ok")) readyRecieve++;
-        else if(data.startsWith("wa")) readyRecieve=1;
+        if(data.startsWith("ok"))
+        {
+            readyRecieve++;
+            if(!inFlight.isEmpty())
+            {
+                SentLine sent = inFlight.takeFirst();
+                if(sent.fileText)
+                    latency.record(LatencyProfile::classify(sent.fileText, sent.length),
+                                   linkClock.nsecsElapsed() - sent.sentAt);
+                else if(!sent.command.isEmpty()) //Not an uploaded line
+                    latency.record(LatencyProfile::classify(sent.command.constData(), sent.command.size()),
+                                   linkClock.nsecsElapsed() - sent.sentAt);
+                bool refused = sent.rejected && sent.fileLine >= 0; //Sent again after the resend
+                if(!refused && sent.fileText) machineState.update(sent.fileText, sent.length);
+                else if(!refused) machineState.update(sent.command);
+                bool current = !refused && sent.fileLine >= 0 && sent.job == jobNumber; //Not a late line of the previous job
+                if(current) ackedLine = sent.fileLine + 1;
+                if(current && sent.fileText && telemetry.acknowledged(sent.fileLine))
+                    printMsg(telemetry.summary());
+                if(inFlight.isEmpty()) finishingJob.clear(); //Nothing points into the previous file anymore
+            }
+            if(resyncing) finishResync(true); //M110 answered without a reset
+        }
+        else if(data.startsWith("wa")) lostAcks();
+        else if(data.startsWith("rs") || data.startsWith("Resend")) resendFrom(Parser::resendLine(data));
+        else if(resyncing && data.startsWith("start")) finishResync(false);
 
         printMsg(QString(data)); //echo
     }
 }
 
-void MainWindow::printMsg(const char* text)
+void MainWindow::lostAcks()
 {
-    QTextCursor cursor = ui->terminal->textCursor();
-    cursor.movePosition(QTextCursor::End);
+    //"wait" means the firmware is idle, so whatever is still in flight lost its "ok"
+    //or never arrived. Pairing later acks with these lines would shift every one of them.
+    readyRecieve = linkWindow;
+    if(inFlight.isEmpty()) return;
 
-    cursor.insertText(text);
+    inFlight.clear();
+    finishingJob.clear();
+    if(sending && sendingChecksum && currentLine > ackedLine)
+        currentLine = ackedLine; //Numbered lines it already has are refused and asked for again
+}
 
-    ui->terminal->setTextCursor(cursor);
-;
+void MainWindow::resendFrom(long asked)
+{
+    //Firmware still answers every line in flight, the ones after the bad line
+    //are refused and asked for again too, so only the first request rewinds
+    if(!sending || inFlight.isEmpty() || inFlight.first().rejected) return;
+
+    long oldest = -1;
+    for(int i = inFlight.firstIndex(); i <= inFlight.lastIndex(); i++)
+    {
+        inFlight[i].rejected = true;
+        if(oldest == -1 && inFlight.at(i).fileLine >= 0 && inFlight.at(i).job == jobNumber)
+            oldest = inFlight.at(i).fileLine;
+    }
+    if(oldest == -1) return; //No file line is waiting, an injected command was refused
+
+    //Line i of the file is sent as N<i + 1>. Lines from the oldest waiting one on were
+    //never accepted, so the firmware asking for a later one must not skip them;
+    //an earlier one means acks we counted were not for lines it kept.
+    //Without numbers the oldest waiting line is the best guess.
+    if(sendingChecksum && asked >= 1 && asked - 1 < oldest) currentLine = asked - 1;
+    else currentLine = oldest;
+    if(ackedLine > currentLine) ackedLine = currentLine;
+}
+
+void MainWindow::printMsg(const char* text)
+{
+    printMsg(QString(text));
 }
 
 void MainWindow::printMsg(QString text)
 {
+    TerminalEntry entry;
+    entry.text = text;
+    entry.first = 0;
+    entry.count = 0;
+    terminalQueue.append(entry);
+}
+
+void MainWindow::echoFileLines(long first, int count)
+{
+    //Only the line numbers are kept, a run just grows the last entry
+    if(!terminalQueue.isEmpty() && terminalQueue.last().text.isNull()
+            && terminalQueue.last().first + terminalQueue.last().count == first)
+    {
+        terminalQueue.last().count += count;
+        return;
+    }
+
+    TerminalEntry entry;
+    entry.first = first;
+    entry.count = count;
+    terminalQueue.append(entry);
+}
+
+void MainWindow::flushTerminal()
+{
+    if(terminalQueue.isEmpty()) return;
+
+    QString text;
+    for(int i = 0; i < terminalQueue.size(); i++)
+    {
+        const TerminalEntry &entry = terminalQueue.at(i);
+        if(!entry.text.isNull()) text += entry.text;
+        else for(long l = entry.first; l < entry.first + entry.count && l < gcode.size(); l++)
+            text += QLatin1String(gcode.line(l), gcode.length(l) + 1);
+    }
+    terminalQueue.resize(0); //Keeps the capacity for the next batch
+
     QTextCursor cursor = ui->terminal->textCursor();
     cursor.movePosition(QTextCursor::End);
 
@@ -574,9 +1183,16 @@ void MainWindow::printMsg(QString text)
 
 void MainWindow::sendNext()
 {
-    if(!userCommands.isEmpty() && printer.isWritable() && readyRecieve > 0) //Inject user command
+    if(linkProbe->isRunning()) return;
+
+    while(commandQueue.hasEmergency() && printer.isWritable()) //Emergency lane ignores flow control
+        sendLine(commandQueue.dequeue());
+
+    if(parking && inFlight.isEmpty()) parkNozzle(); //Everything sent before the pause is acknowledged
+
+    if(!commandQueue.isEmpty() && printer.isWritable() && readyRecieve > 0) //Inject user command
     {
-        sendLine(userCommands.dequeue());
+        sendLine(commandQueue.dequeue());
         readyRecieve--;
         return;
     }
@@ -584,6 +1200,12 @@ void MainWindow::sendNext()
     {
         if(currentLine >= gcode.size()) //check if we are at the end of array
         {
+            if(!uploading && !jobQueue.isEmpty())
+            {
+                if(jobQueue.isReady()) startNextJob(true);
+                return; //Still loading, the next tick checks again
+            }
+
             sending = false;
             currentLine = 0;
             ui->sendBtn->setText("Send");
@@ -592,31 +1214,166 @@ void MainWindow::sendNext()
                                    + QString("/")
                                    + QString::number(currentLine)
                                    + QString(" Lines"));
+#ifdef ALLOCATION_COUNTER
+            printMsg(QString("Send path: %1 allocations for %2 lines\n").arg(sendAllocations).arg(gcode.size()));
+            sendAllocations = 0;
+#endif
+            if(uploading) finishUpload();
             if(sendingChecksum) injectCommand("M110 N0");
             return;
         }
-        sendLine(gcode.at(currentLine));
-        currentLine++;
-        readyRecieve--;
-
-        ui->filelines->setText(QString::number(gcode.size())
-                               + QString("/")
-                               + QString::number(currentLine)
-                               + QString(" Lines"));
-        ui->progressBar->setValue(((float)currentLine/gcode.size()) * 100);
+#ifdef ALLOCATION_COUNTER
+        int allocations = AllocationCounter::count();
+#endif
+        //Fill the whole free window, labels follow on the state timer
+        while(readyRecieve > 0 && currentLine < gcode.size())
+        {
+            int sent = sendFileLines(currentLine, readyRecieve);
+            if(!sent) break;
+            currentLine += sent;
+            readyRecieve -= sent;
+        }
+        if(toolpathwindow) toolpathwindow->setCurrentLine(currentLine);
+#ifdef ALLOCATION_COUNTER
+        sendAllocations += AllocationCounter::count() - allocations;
+#endif
     }
 }
 
 void MainWindow::checkStatus()
 {
-    if(checkingTemperature
-            &&(sinceLastTemp.elapsed() > statusTimer.interval())) injectCommand("M105");
+    if(checkingTemperature && !autoreportTemperature && !uploading //Would be written to the SD file
+            &&(sinceLastTemp.elapsed() > statusTimer.interval())) injectCommand("M105", StatusLane);
+}
+
+void MainWindow::parkNozzle()
+{
+    double retract = settings.value("printer/pauseretract", 2).toDouble();
+    double lift = settings.value("printer/pauselift", 5).toDouble();
+    QString command = "M400\n"; //Let the planner run empty
+
+    pausedState = machineState;
+    parking = false;
+    parked = true;
+
+    if(retract > 0) command += "M83\nG1 E-" + QString::number(retract) + " F2400\n";
+    if(lift > 0) command += "G91\nG1 Z" + QString::number(lift) + " F600\n";
+    command += "G90\nG1 X" + settings.value("printer/parkx", 0).toString()
+            + " Y" + settings.value("printer/parky", 0).toString() + " F6000";
+
+    injectCommand(command);
+}
+
+void MainWindow::returnFromPark()
+{
+    const MachineState &s = pausedState;
+    double retract = settings.value("printer/pauseretract", 2).toDouble();
+    QString command;
+
+    //Heaters could have been changed or switched off while parked
+    if(s.extruderTarget > 0 && (machineState.extruderTarget != s.extruderTarget
+                                || machineState.extruderTemp < s.extruderTarget - 5))
+        command += "M109 S" + QString::number(s.extruderTarget) + "\n";
+    if(s.bedTarget > 0 && (machineState.bedTarget != s.bedTarget
+                           || machineState.bedTemp < s.bedTarget - 3))
+        command += "M190 S" + QString::number(s.bedTarget) + "\n";
+
+    command += "G90\nG1 X" + QString::number(s.x) + " Y" + QString::number(s.y) + " F6000\n";
+    command += "G1 Z" + QString::number(s.z) + " F600\n";
+    if(retract > 0) command += "M83\nG1 E" + QString::number(retract) + " F2400\n";
+
+    //G90/G91 set the extruder mode too, so M82/M83 goes after them
+    command += s.absolute ? "G90\n" : "G91\n";
+    command += s.absoluteE ? "M82" : "M83";
+    if(s.feedrate > 0) command += "\nG1 F" + QString::number(s.feedrate);
+
+    injectCommand(command);
+}
+
+void MainWindow::updateMachineState()
+{
+    ui->positionLine->setText(machineState.positionString());
+    if(sending && !sdprinting) updateFileProgress();
+    if(sending && !uploading) ui->layerLine->setText(telemetry.layerString());
+
+    if(controlServer.isListening()) //Pushed to clients only when something changed
+    {
+        QJsonObject status;
+        status["connected"] = printer.isOpen();
+        status["sending"] = sending;
+        status["paused"] = paused;
+        status["sdprinting"] = sdprinting;
+        status["uploading"] = uploading;
+        status["file"] = gfile.fileName();
+        status["line"] = double(currentLine);
+        status["lines"] = gcode.size();
+        status["x"] = machineState.x;
+        status["y"] = machineState.y;
+        status["z"] = machineState.z;
+        status["e"] = machineState.e;
+        status["extruder"] = machineState.extruderTemp;
+        status["extrudertarget"] = machineState.extruderTarget;
+        status["bed"] = machineState.bedTemp;
+        status["bedtarget"] = machineState.bedTarget;
+        controlServer.setStatus(status);
+    }
+}
+
+//Remote requests are refused where the UI would not allow them, the reason
+//goes back to the client instead of the request being dropped
+
+void MainWindow::remoteInject(QString command, CommandLane lane, QString *error)
+{
+    //Anything sent during an upload ends up in the file on the card. Emergency
+    //commands still go, firmware catches M112 before it is stored
+    if(uploading && lane != EmergencyLane) *error = "SD upload in progress";
+    else if(!printer.isOpen()) *error = "Printer is not connected";
+    else injectCommand(command, lane);
+}
+
+void MainWindow::remoteOpen(QString filename, QString *error)
+{
+    if(uploading) *error = "SD upload in progress";
+    else if(sending) *error = "Print in progress"; //Never swap the file under a running print
+    else
+    {
+        sdprinting = false;
+        parseFile(filename, error);
+    }
+}
+
+void MainWindow::remoteStart(QString *error)
+{
+    if(uploading) *error = "SD upload in progress";
+    else if(sending) *error = "Already printing";
+    else if(!ui->sendBtn->isEnabled()) *error = "Printer is not connected";
+    else if(gcode.isEmpty() && !sdprinting) *error = "No file loaded";
+    else ui->sendBtn->click();
+}
+
+void MainWindow::remotePause(QString *error)
+{
+    if(!sending || !ui->pauseBtn->isEnabled()) *error = "Not printing";
+    else ui->pauseBtn->click();
+}
+
+void MainWindow::remoteStop(QString *error)
+{
+    if(!sending) *error = "Not printing";
+    else ui->sendBtn->click();
 }
 
 void MainWindow::on_checktemp_stateChanged(int arg1)
 {
     if(arg1) checkingTemperature = true;
     else checkingTemperature = false;
+
+    if(autoreportTemperature)
+    {
+        if(checkingTemperature)
+            injectCommand("M155 S" + QString::number(qMax(1, statusTimer.interval()/1000)));
+        else injectCommand("M155 S0");
+    }
 }
 
 void MainWindow::on_actionSettings_triggered()
@@ -624,6 +1381,24 @@ void MainWindow::on_actionSettings_triggered()
     SettingsWindow settingswindow(this);
 
     settingswindow.exec();
+    jobQueue.setMerging(mergeLimits()); //Files opened from now on
+
+    bool wirelog = settings.value("core/wirelog", 0).toBool();
+    if(wirelog && !wireLogger.isLogging())
+        wireLogger.startLogging(QStandardPaths::writableLocation(QStandardPaths::DataLocation) + "/wirelog");
+    else if(!wirelog && wireLogger.isLogging())
+        wireLogger.stopLogging();
+}
+
+SegmentMerger::Limits MainWindow::mergeLimits()
+{
+    SegmentMerger::Limits limits;
+    limits.enabled = settings.value("printer/mergesegments", 0).toBool();
+    limits.deviation = settings.value("printer/mergedeviation", 0.02).toDouble();
+    limits.maxRate = settings.value("printer/maxsegmentrate", 0).toInt();
+    //Lines per second the port carried on connect, an upper bound only: the planner is not measured
+    if(limits.maxRate <= 0) limits.maxRate = settings.value("printer/linkrate", 0).toDouble();
+    return limits;
 }
 
 void MainWindow::on_actionAbout_triggered()
@@ -633,26 +1408,38 @@ void MainWindow::on_actionAbout_triggered()
     aboutwindow.exec();
 }
 
-void MainWindow::injectCommand(QString command)
+void MainWindow::injectCommand(QString command, CommandLane lane)
 {
-    if(!userCommands.contains(command)) userCommands.enqueue(command);
+    commandQueue.enqueue(command, lane);
+    if(lane == EmergencyLane) sendNext(); //Do not wait for the sender timer
+}
+
+void MainWindow::loadRecent()
+{
+    if(recentLoaded) return;
+    recentLoaded = true;
+
+    int size = settings.beginReadArray("user/recentfiles");
+    for(int i = 0; i < size; ++i)
+    {
+        settings.setArrayIndex(i);
+        recentFiles.append(settings.value("user/file").toString());
+    }
+    settings.endArray();
 }
 
 void MainWindow::updateRecent()
 {
-    if(!recentFiles.isEmpty()) //If array is empty we should not be bothered
+    loadRecent();
+
+    recentMenu->clear(); //Clear menu from previos actions, it owns them
+    foreach (QString str, recentFiles)
     {
-        recentMenu->clear(); //Clear menu from previos actions
-        foreach (QString str, recentFiles)
+        if (!str.isEmpty()) //Empty strings are not needed
         {
-            if (!str.isEmpty()) //Empty strings are not needed
-            {
-                QAction *action = new QAction(this);
-                action->setText(str); //Set filepath as a title
-                action->setObjectName(str); //Also set name to the path so we can get it later
-                recentMenu->addAction(action); //Add action to the menu
-                connect(action, SIGNAL(triggered()), this, SLOT(recentClicked()));
-            }
+            QAction *action = recentMenu->addAction(str); //Set filepath as a title
+            action->setObjectName(str); //Also set name to the path so we can get it later
+            connect(action, SIGNAL(triggered()), this, SLOT(recentClicked()));
         }
     }
 }
@@ -662,20 +1449,37 @@ void MainWindow::serialError(QSerialPort::SerialPortError error)
     if(error == QSerialPort::NoError) return;
     if(error == QSerialPort::NotOpenError) return; //this error is internal
 
-    if(printer.isOpen()) printer.close();
+    if(reconnecting) return; //Opening a port that is still settling fails, the timer tries again
+
+    bool wasOpen = printer.isOpen();
+    linkProbe->stop();
+    if(wasOpen)
+    {
+        lostBaud = printer.baudRate();
+        if(!resyncing) lostPort = printerinfo;
+        printer.close();
+    }
+
+    commandQueue.clear();
+    verifyingUpload = false; //Otherwise the end of later SD prints is ignored
+
+    if(wasOpen && !uploading && settings.value("core/autoreconnect", 1).toBool()
+            && (error == QSerialPort::ResourceError || error == QSerialPort::DeviceNotFoundError
+                || error == QSerialPort::ReadError || error == QSerialPort::WriteError))
+    {
+        startReconnect();
+        return;
+    }
 
     if(sending) paused = true;
+    resyncing = false;
+    resyncTimer.stop();
 
-    userCommands.clear();
+    resetAutoreport();
+    inFlight.clear();
+    machineState.reset();
 
-    ui->connectBtn->setText("Connect");
-    ui->sendBtn->setDisabled(true);
-    ui->pauseBtn->setDisabled(true);
-    ui->controlBox->setDisabled(true);
-    ui->consoleGroup->setDisabled(true);
-    ui->actionPrint_from_SD->setDisabled(true);
-    ui->actionSet_SD_printing_mode->setDisabled(true);
-    ui->actionEEPROM_editor->setDisabled(true);
+    setConnectedUi(false);
 
     qDebug() << error;
 
@@ -722,6 +1526,9 @@ void MainWindow::updateTemperature(TemperatureReadings r)
     ui->bedlcd->display(r.b);
     ui->tempLine->setText(r.raw);
     sinceLastTemp.restart();
+    machineState.setTemperature(r.e, r.b);
+
+    temperatureHistory.append(QDateTime::currentMSecsSinceEpoch(), r.e, r.b);
 }
 
 void MainWindow::on_actionAbout_Qt_triggered()
@@ -729,35 +1536,42 @@ void MainWindow::on_actionAbout_Qt_triggered()
     qApp->aboutQt();
 }
 
-void MainWindow::initSDprinting(QStringList sdFiles)
+void MainWindow::initSDprinting()
 {
-    SDWindow sdwindow(sdFiles, this); //Made it to 666 lines!
+    sdFiles.clear();
+    if(verifyingUpload) return; //This listing was requested after an upload
 
-    connect(&sdwindow, SIGNAL(fileSelected(QString)), this, SLOT(selectSDfile(QString)));
-
-    sdwindow.exec();
+    if(!sdwindow)
+    {
+        sdwindow = new SDWindow(&sdFiles, this); //Made it to 666 lines!
+        sdwindow->setAttribute(Qt::WA_DeleteOnClose);
+        connect(sdwindow, &SDWindow::fileSelected, this, &MainWindow::selectSDfile);
+    }
+    sdwindow->show();
+    sdwindow->raise();
 }
 
-
-void MainWindow::selectSDfile(QString file)
+void MainWindow::sdListingFinished()
 {
-    QStringList split = file.split(' ');
-    QString bytes = split.at(split.size()-1);
-    QString filename = file.remove(" "+bytes);
+    if(verifyingUpload) verifyUpload();
+    else if(sdwindow) sdwindow->listingFinished();
+}
 
-    ui->filename->setText(filename);
+void MainWindow::selectSDfile(SDFile file)
+{
+    ui->filename->setText(file.longName.isEmpty() ? file.name : file.longName);
     if(chekingSDStatus)
     {
-        ui->filelines->setText(bytes + QString("/0 bytes"));
+        ui->filelines->setText(QString::number(file.size) + QString("/0 bytes"));
         ui->progressBar->setEnabled(true);
         ui->progressBar->setValue(0);
     }
     else ui->progressBar->setDisabled(true);
     ui->sendBtn->setText("Start");
-    sdBytes = bytes.toDouble();
+    sdBytes = qMax<qint64>(0, file.size);
 
-    userCommands.clear();
-    injectCommand("M23 " + filename);
+    commandQueue.clear();
+    injectCommand("M23 " + file.name); //Short name works on every firmware
     sdprinting = true;
     ui->fileBox->setDisabled(false);
 }
@@ -776,8 +1590,9 @@ void MainWindow::updateSDStatus(SDProgress p)
 
 void MainWindow::checkSDStatus()
 {
-    if(sdprinting && chekingSDStatus && sinceLastSDStatus.elapsed() > progressSDTimer.interval())
-        injectCommand("M27");
+    if(sdprinting && chekingSDStatus && !autoreportSD
+            && sinceLastSDStatus.elapsed() > progressSDTimer.interval())
+        injectCommand("M27", StatusLane);
 }
 
 void MainWindow::on_stepspin_valueChanged(const QString &arg1)
@@ -802,8 +1617,8 @@ void MainWindow::on_actionSet_SD_printing_mode_triggered()
 
 void MainWindow::requestEEPROMSettings()
 {
-    userCommands.clear();
-    EEPROMSettings.clear();
+    commandQueue.clear();
+    eepromSettings.clear();
 
     switch(firmware)
     {
@@ -813,7 +1628,7 @@ void MainWindow::requestEEPROMSettings()
     case Repetier:
         injectCommand("M205");
         break;
-    case OtherFirmware:
+    default:
         return;
     }
 
@@ -825,9 +1640,91 @@ void MainWindow::on_actionEEPROM_editor_triggered()
     requestEEPROMSettings();
 }
 
+void MainWindow::on_actionTemperature_graph_triggered()
+{
+    TemperatureWindow *temperaturewindow = new TemperatureWindow(&temperatureHistory, this);
+
+    temperaturewindow->setAttribute(Qt::WA_DeleteOnClose);
+    temperaturewindow->show(); //Non-modal, the graph updates while printing
+}
+
+void MainWindow::on_actionCommand_latency_triggered()
+{
+    LatencyWindow *latencywindow = new LatencyWindow(&latency, this);
+
+    latencywindow->setAttribute(Qt::WA_DeleteOnClose);
+    latencywindow->show();
+}
+
+void MainWindow::on_actionToolpath_preview_triggered()
+{
+    if(!toolpathwindow)
+    {
+        toolpathwindow = new ToolpathWindow(this);
+        toolpathwindow->setAttribute(Qt::WA_DeleteOnClose);
+        toolpathwindow->setToolpath(toolpath.data());
+        toolpathwindow->setCurrentLine(currentLine);
+    }
+    toolpathwindow->show();
+    toolpathwindow->raise();
+}
+
+void MainWindow::toolpathReady()
+{
+    QSharedPointer<Toolpath> result = toolpathWatcher.result();
+    if(result.isNull()) return; //Cancelled by a newer file
+
+    if(toolpathwindow) toolpathwindow->setToolpath(result.data());
+    toolpath = result;
+}
+
+void MainWindow::on_actionValidate_GCode_triggered()
+{
+    if(validatorWatcher.isRunning())
+    {
+        QMessageBox::information(this, "G-code validator", "File is still being checked");
+        return;
+    }
+
+    showValidationIssues();
+}
+
+void MainWindow::validationDone()
+{
+    validationIssues = validatorWatcher.result();
+    if(!validationIssues.isEmpty()) showValidationIssues();
+}
+
+void MainWindow::showValidationIssues()
+{
+    QMessageBox box(this);
+    box.setWindowTitle("G-code validator");
+
+    if(gcode.isEmpty()) box.setText("No file opened");
+    else if(validationIssues.isEmpty())
+    {
+        box.setIcon(QMessageBox::Information);
+        box.setText("No problems found");
+    }
+    else
+    {
+        QString details;
+        for(int i = 0; i < validationIssues.size() && i < 1000; i++)
+            details += "Line " + QString::number(validationIssues.at(i).line)
+                    + ": " + validationIssues.at(i).message + "\n";
+
+        box.setIcon(QMessageBox::Warning);
+        box.setText(QString::number(validationIssues.size()) + " problems found in "
+                    + gfile.fileName().split(QDir::separator()).last());
+        box.setDetailedText(details);
+    }
+
+    box.exec();
+}
+
 void MainWindow::openEEPROMeditor()
 {
-    EEPROMWindow eepromwindow(EEPROMSettings, this);
+    EEPROMWindow eepromwindow(&eepromSettings, firmware, this);
 
     eepromwindow.setWindowModality(Qt::NonModal);
     connect(&eepromwindow, SIGNAL(changesComplete(QStringList)), this, SLOT(sendEEPROMsettings(QStringList)));
@@ -837,7 +1734,7 @@ void MainWindow::openEEPROMeditor()
 
 void MainWindow::sendEEPROMsettings(QStringList changes)
 {
-    userCommands.clear();
+    commandQueue.clear();
     foreach (QString str, changes)
     {
         injectCommand(str);
@@ -852,33 +1749,26 @@ void MainWindow::recievedOkNum(int num)
 
 void MainWindow::recievedWait()
 {
-    readyRecieve = 1;
-}
-
-void MainWindow::EEPROMSettingRecieved(QString esetting)
-{
-    EEPROMSettings.append(esetting);
+    readyRecieve = linkWindow;
 }
 
 void MainWindow::recievedError()
 {
+    verifyingUpload = false; //Listing after M29 may never come
     ErrorWindow errorwindow(this,"Hardware failure");
     errorwindow.exec();
 }
 
 void MainWindow::recievedSDDone()
 {
+    if(verifyingUpload) return; //"Done saving file", not the end of SD print
+
     sdprinting=false;
     ui->progressBar->setValue(0);
     ui->filename->setText("");
     ui->fileBox->setDisabled(true);
 }
 
-void MainWindow::recievedResend(int num)
-{
-    if(!sendingChecksum) currentLine--;
-}
-
 bool MainWindow::eventFilter(QObject *obj, QEvent *event)
 {
     if(obj == ui->sendtext && !userHistory.isEmpty())
@@ -911,3 +1801,123 @@ void MainWindow::recentClicked()
 {
     parseFile(sender()->objectName());
 }
+
+void MainWindow::recievedCapability(QString cap, bool enabled)
+{
+    //Firmware reports on its own, so polling timers only act as a fallback
+    if(cap == "AUTOREPORT_TEMP")
+    {
+        autoreportTemperature = enabled;
+        if(enabled && checkingTemperature)
+            injectCommand("M155 S" + QString::number(qMax(1, statusTimer.interval()/1000)));
+    }
+    else if(cap == "AUTOREPORT_SD_STATUS")
+    {
+        autoreportSD = enabled;
+        if(enabled && chekingSDStatus)
+            injectCommand("M27 S" + QString::number(qMax(1, progressSDTimer.interval()/1000)));
+    }
+}
+
+void MainWindow::resetAutoreport()
+{
+    autoreportTemperature = false;
+    autoreportSD = false;
+}
+
+void MainWindow::on_actionUpload_to_SD_triggered()
+{
+    if(gcode.isEmpty() || sending || sdprinting) return;
+
+    //Most firmwares only handle 8.3 names
+    QString suggested = QFileInfo(gfile.fileName()).completeBaseName().left(8).toLower() + ".gco";
+    bool ok;
+    QString name = QInputDialog::getText(this, "Upload to SD", "File name on SD card:",
+                                         QLineEdit::Normal, suggested, &ok);
+    if(!ok || name.trimmed().isEmpty()) return;
+
+    uploadName = name.trimmed();
+    uploadBytes = 0;
+    uploadSize = 0;
+    for(int i = 0; i < gcode.size(); i++) uploadSize += uploadSizeOf(gcode.line(i), gcode.length(i));
+
+    //File lines go through the usual windowed sender, wrapped in M28/M29
+    commandQueue.clear();
+    if(sendingChecksum) injectCommand("M110 N0"); //Uploaded lines are numbered from N1 too
+    injectCommand("M28 " + uploadName);
+    uploading = true;
+    sending = true;
+    paused = false;
+    currentLine = 0;
+    uploadTime.start();
+
+    ui->sendBtn->setText("Stop");
+    ui->pauseBtn->setDisabled(true);
+    ui->controlBox->setDisabled(true); //Anything sent now would end up in the file
+    ui->consoleGroup->setDisabled(true);
+    ui->progressBar->setValue(0);
+}
+
+qint64 MainWindow::uploadSizeOf(const char *line, int length) const
+{
+    //Firmware stores the line without line number and checksum, ending with \r\n
+    int begin = 0, end = length;
+    if(sendingChecksum)
+    {
+        begin = (const char*)memchr(line, ' ', length) - line + 1;
+        while(end > 0 && line[end-1] != '*') end--;
+        end--;
+    }
+    return end - begin + 2;
+}
+
+void MainWindow::finishUpload()
+{
+    injectCommand("M29 " + uploadName);
+    injectCommand("M20"); //Listing is used to verify the size
+    uploading = false;
+    verifyingUpload = true;
+
+    qint64 msecs = qMax<qint64>(1, uploadTime.elapsed());
+    printMsg("Uploaded " + QString::number(uploadBytes) + " bytes in "
+             + QString::number(msecs / 1000.0) + " s, "
+             + QString::number(uploadBytes / msecs) + " kB/s\n");
+
+    ui->controlBox->setDisabled(false);
+    ui->consoleGroup->setDisabled(false);
+}
+
+void MainWindow::abortUpload()
+{
+    injectCommand("M29 " + uploadName); //Close the incomplete file
+    uploading = false;
+    sending = false;
+    currentLine = 0;
+
+    ui->sendBtn->setText("Send");
+    ui->progressBar->setValue(0);
+    ui->controlBox->setDisabled(false);
+    ui->consoleGroup->setDisabled(false);
+    printMsg("Upload of " + uploadName + " cancelled\n");
+}
+
+void MainWindow::verifyUpload()
+{
+    verifyingUpload = false;
+
+    int row = sdFiles.find(uploadName);
+    if(row == -1)
+    {
+        QMessageBox::warning(this, "Upload to SD", uploadName + " was not found on the card");
+        return;
+    }
+
+    qint64 size = sdFiles.file(row).size;
+    if(size == uploadSize || firmware != Marlin) //Repetier stores files in its binary format
+        QMessageBox::information(this, "Upload to SD", uploadName + " uploaded, "
+                                 + QString::number(size) + " bytes on card");
+    else
+        QMessageBox::warning(this, "Upload to SD", uploadName + " has "
+                             + QString::number(size) + " bytes on card, "
+                             + QString::number(uploadSize) + " expected");
+}
@@ -13,6 +13,11 @@
 #include <QElapsedTimer>
 #include <QMessageBox>
 #include <QRegExp>
+#include <QPointer>
+#include <QInputDialog>
+#include <QContiguousCache>
+#include <QStandardPaths>
+#include <QTimer>
 
 #include "settingswindow.h"
 #include "aboutwindow.h"
@@ -20,7 +25,26 @@
 #include "sdwindow.h"
 #include "repraptor.h"
 #include "eepromwindow.h"
+#include "eeprommodel.h"
 #include "parser.h"
+#include "commandqueue.h"
+#include "temperaturehistory.h"
+#include "temperaturewindow.h"
+#include "toolpath.h"
+#include "toolpathwindow.h"
+#include "gcodevalidator.h"
+#include "machinestate.h"
+#include "wirelogger.h"
+#include "controlserver.h"
+#include "linkprobe.h"
+#include "jobqueue.h"
+#include "gcodestore.h"
+#include "telemetry.h"
+#include "latencyprofile.h"
+#include "latencywindow.h"
+#include "portwatcher.h"
+#include "startupprofile.h"
+#include "allocationcounter.h"
 
 using namespace RepRaptor;
 
@@ -41,18 +65,61 @@ public:
 
 protected:
     QFile gfile;
-    QVector<QString> gcode;
-    QQueue <QString> userCommands;
+    GCodeStore gcode;
+    GCodeStore finishingJob; //Keeps lines of the previous file alive until they are acknowledged
+    CommandQueue commandQueue;
     QTimer sendTimer;
     QTimer progressSDTimer;
     QTimer statusTimer;
+    QTimer stateTimer;
+    QTimer reconnectTimer;
+    QTimer resyncTimer;
+    QTimer terminalTimer;
+    QElapsedTimer reconnectTime;
     QElapsedTimer sinceLastTemp;
     QElapsedTimer sinceLastSDStatus;
     QSettings settings;
     QStringList recentFiles;
-    QStringList EEPROMSettings;
+    bool recentLoaded;
+    PortWatcher portWatcher;
+    EEPROMModel eepromSettings;
     QStringList userHistory;
     QMenu *recentMenu;
+    TemperatureHistory temperatureHistory;
+    QSharedPointer<Toolpath> toolpath;
+    QFutureWatcher< QSharedPointer<Toolpath> > toolpathWatcher;
+    QAtomicInt toolpathGeneration;
+    QPointer<ToolpathWindow> toolpathwindow;
+    SDFileModel sdFiles;
+    QPointer<SDWindow> sdwindow;
+    QFutureWatcher< QList<GCodeValidator::Issue> > validatorWatcher;
+    QList<GCodeValidator::Issue> validationIssues;
+    MachineState machineState;
+    MachineState pausedState;
+    WireLogger wireLogger;
+    ControlServer controlServer;
+    JobQueue jobQueue;
+    PrintTelemetry telemetry;
+    LatencyProfile latency;
+    QElapsedTimer linkClock; //Time base of SentLine::sentAt
+    typedef struct
+    {
+        QByteArray command;     //Injected command
+        const char *fileText;   //File line in the store, 0 for commands and uploaded lines
+        int length;
+        long fileLine;          //Index in gcode, -1 for injected commands
+        int job;                //jobNumber when sent
+        bool rejected;          //Sent before a resend request, its ack is not a success
+        qint64 sentAt;          //ns
+    } SentLine;
+    QContiguousCache<SentLine> inFlight; //Sent lines waiting for "ok", a ring that does not allocate per line
+    typedef struct
+    {
+        QString text;           //Null for echoed file lines
+        long first;             //Echoed lines are read back from gcode when shown
+        int count;
+    } TerminalEntry;
+    QVector<TerminalEntry> terminalQueue; //Shown on terminalTimer, in one insert
 
     bool eventFilter(QObject *target, QEvent *event);
 
@@ -61,6 +128,10 @@ private:
 
     QSerialPort printer;
     QSerialPortInfo printerinfo;
+    QString printerIdentity;    //PortWatcher::uniqueIdentity of the connected board, empty if it has none
+    LinkProbe *linkProbe;
+    QSerialPortInfo lostPort;
+    qint32 lostBaud;
     bool firstrun;
     bool autolock;
     bool sending;
@@ -71,40 +142,93 @@ private:
     bool echo;
     bool sendingChecksum;
     bool chekingSDStatus;
+    bool uploading;
+    bool verifyingUpload;
+    bool autoreportTemperature;
+    bool autoreportSD;
+    bool parking;           //Paused, waiting for sent lines to drain before parking
+    bool parked;
+    bool reconnecting;      //Port was lost, looking for it again
+    bool resyncing;         //Reopened, waiting to learn if the firmware was reset
+    bool resumeAfterReconnect;
     int firmware;
     long int currentLine;
+    long int ackedLine;     //File lines acknowledged by the firmware
+    int jobNumber;          //Bumped when lines are sent from the start again, older acks are late
     unsigned long int lastRecieved;
     int readyRecieve;
+    int linkWindow;         //Lines allowed in flight, chosen by the link probe
     int userHistoryPos;
     unsigned long int sdBytes;
+    QString uploadName;
+    qint64 uploadBytes;
+    qint64 uploadSize;
+    QElapsedTimer uploadTime;
+#ifdef ALLOCATION_COUNTER
+    int sendAllocations;
+#endif
+
+    qint64 uploadSizeOf(const char *line, int length) const;
+    void resendFrom(long asked);
+    void lostAcks();
+    SegmentMerger::Limits mergeLimits();
+    void rememberPrinter(const QSerialPortInfo &info);
 
 private slots:
     void open();
     void serialconnect();
+    void linkReady(bool probed);
+    void probeFinished(bool ok);
+    void setConnectedUi(bool connected);
+    void startReconnect();
+    void tryReconnect();
+    void finishResync(bool survived);
+    void resyncTimeout();
     void serialupdate();
+    void portsChanged();
+    void portArrived(const QSerialPortInfo &info);
+    void startDeferred();
     bool sendLine(QString line);
+    int sendFileLines(long first, int count);
+    void updateFileProgress();
     void readSerial();
     void printMsg(QString text);
     void printMsg(const char* text);
+    void echoFileLines(long first, int count);
+    void flushTerminal();
     void sendNext();
     void checkStatus();
+    void updateMachineState();
+    void parkNozzle();
+    void returnFromPark();
+    void remoteOpen(QString filename, QString *error);
+    void fileLoaded();
+    void startNextJob(bool between);
+    void jobQueueChanged();
+    void jobLoadFailed(QString filename, QString error);
+    void remoteInject(QString command, CommandLane lane, QString *error);
+    void remoteStart(QString *error);
+    void remotePause(QString *error);
+    void remoteStop(QString *error);
     void updateRecent();
-    void injectCommand(QString command);
-    void initSDprinting(QStringList sdFiles);
-    void selectSDfile(QString file);
+    void loadRecent();
+    void injectCommand(QString command, CommandLane lane = UserLane);
+    void initSDprinting();
+    void sdListingFinished();
+    void selectSDfile(SDFile file);
     void checkSDStatus();
     void updateSDStatus(SDProgress p);
     void requestEEPROMSettings();
     void openEEPROMeditor();
     void sendEEPROMsettings(QStringList changes);
     void updateTemperature(TemperatureReadings r);
-    void EEPROMSettingRecieved(QString esetting);
     void recievedOkNum(int num);
     void recievedWait();
     void recievedError();
     void recievedSDDone();
-    void recievedResend(int num);
-    void parseFile(QString filename);
+    void recievedCapability(QString cap, bool enabled);
+    void resetAutoreport();
+    void parseFile(QString filename, QString *error = 0);
     void recentClicked();
 
     void xplus();
@@ -150,12 +274,27 @@ private slots:
     void on_actionPrint_from_SD_triggered();
     void on_actionSet_SD_printing_mode_triggered();
     void on_actionEEPROM_editor_triggered();
+    void on_actionUpload_to_SD_triggered();
+    void finishUpload();
+    void abortUpload();
+    void verifyUpload();
+    void on_actionTemperature_graph_triggered();
+    void on_actionToolpath_preview_triggered();
+    void on_actionQueue_files_triggered();
+    void on_actionClear_job_queue_triggered();
+    void on_actionExport_print_statistics_triggered();
+    void on_actionCommand_latency_triggered();
+    void toolpathReady();
+    void on_actionValidate_GCode_triggered();
+    void validationDone();
+    void showValidationIssues();
 
 signals:
     void sdReady();
     void eepromReady();
     void recievedData(QByteArray);
     void startedReadingEEPROM();
+    void firmwareDetected(int firmware);
 };
 
 #endif // MAINWINDOW_H
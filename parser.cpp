@@ -6,14 +6,13 @@ Parser::Parser(QObject *parent):
     this->setParent(parent);
     temperatureRegxp.setCaseSensitivity(Qt::CaseInsensitive);
     temperatureRegxp.setPatternSyntax(QRegExp::RegExp);
-    temperatureRegxp.setPattern("\\d+\\.\\d+"); // Find float in string
+    temperatureRegxp.setPattern("\\d+(\\.\\d+)?"); // Find number in string, some firmwares send "T:20 /0"
 
     readingFiles = false;
     readingEEPROM = false;
     EEPROMReadingStarted = false;
-
-    QSettings settings;
-    firmware = settings.value("printer/firmware").toInt();
+    EEPROMGroup = 0;
+    firmware = AutoFirmware; //Owner sets it with setFirmware(), settings are not read here
 }
 
 Parser::~Parser()
@@ -21,17 +20,134 @@ Parser::~Parser()
 
 }
 
+//Marlin lists the 8.3 DOS name first, so "PART~1.GCO 1234 bracket 2" is
+//a long name ending in a number and not a size at the end
+static bool isShortName(const QString &name)
+{
+    int dot = name.indexOf('.');
+    if(dot == -1) return name.size() <= 8;
+    return dot >= 1 && dot <= 8 && name.size() - dot - 1 <= 3 && name.indexOf('.', dot + 1) == -1;
+}
+
+int Parser::resendLine(const QByteArray &data)
+{
+    //"Resend: 12", "Resend:12", "rs 12" or "rs N12", -1 if there is no number
+    int i = 0;
+    while(i < data.size() && (data.at(i) < '0' || data.at(i) > '9')) i++;
+    if(i == data.size()) return -1;
+
+    int line = 0;
+    for(; i < data.size() && data.at(i) >= '0' && data.at(i) <= '9'; i++) line = line * 10 + data.at(i) - '0';
+    return line;
+}
+
+SDFile Parser::parseSDFile(const QByteArray &data)
+{
+    //Possible forms are "NAME.GCO 1234", "NAME.GCO 1234 Long name.gcode"
+    //(Marlin with long names) and "name with spaces.gcode 1234"
+    SDFile f;
+    QString line = QString(data).trimmed();
+    QStringList tmp = line.split(' ', QString::SkipEmptyParts);
+    bool sizeAfterName, sizeAtEnd;
+
+    f.size = -1;
+    if(tmp.isEmpty()) return f;
+
+    qint64 last = tmp.last().toLongLong(&sizeAtEnd);
+    qint64 second = tmp.size() > 1 ? tmp.at(1).toLongLong(&sizeAfterName) : 0;
+    if(tmp.size() < 2) sizeAfterName = false;
+
+    if(tmp.size() > 2 && sizeAfterName && (!sizeAtEnd || isShortName(tmp.at(0))))
+    {
+        f.name = tmp.at(0);
+        f.size = second;
+        f.longName = QStringList(tmp.mid(2)).join(' ');
+    }
+    else if(tmp.size() > 1 && sizeAtEnd)
+    {
+        f.name = line.left(line.lastIndexOf(' ')).trimmed();
+        f.size = last;
+    }
+    else f.name = line;
+
+    return f;
+}
+
+EEPROMSetting Parser::parseRepetierEEPROM(const QByteArray &data)
+{
+    //"EPR:3 145 80.0000 X-axis steps per mm" is type, position, value, description
+    EEPROMSetting s;
+    QStringList tmp = QString(data).trimmed().remove(0, 4).split(' ', QString::SkipEmptyParts);
+
+    s.group = 0;
+    if(tmp.size() < 3) return s;
+
+    s.type = tmp.at(0).toInt();
+    s.position = tmp.at(1).toInt();
+    s.value = tmp.at(2);
+    s.description = QStringList(tmp.mid(3)).join(' ');
+
+    return s;
+}
+
+void Parser::parseMarlinEEPROM(const QByteArray &data)
+{
+    //M503 prints section titles ("echo:Steps per unit:" or "echo:; Steps per unit:")
+    //followed by the commands restoring them ("echo:  M92 X80.00 Y80.00 Z400.00 E93.00")
+    QString line = QString(data).mid(5).trimmed();
+    QString comment;
+
+    int commentPos = line.indexOf(';');
+    if(commentPos != -1)
+    {
+        comment = line.mid(commentPos + 1).trimmed();
+        line = line.left(commentPos).trimmed();
+    }
+
+    QStringList tmp = line.split(' ', QString::SkipEmptyParts);
+    if(tmp.isEmpty() || !QRegExp("[GM]\\d+").exactMatch(tmp.first()))
+    {
+        if(!comment.isEmpty()) EEPROMComment = comment;
+        else if(!line.isEmpty()) EEPROMComment = line;
+        return;
+    }
+
+    QString title = comment.isEmpty() ? EEPROMComment : comment;
+    if(title.endsWith(':')) title.chop(1);
+
+    for(int i = 1; i < tmp.size(); i++)
+    {
+        EEPROMSetting s;
+
+        s.type = EEPROMFloat;
+        s.position = 0;
+        s.group = EEPROMGroup;
+        s.command = tmp.first();
+        s.parameter = tmp.at(i).at(0);
+        s.value = tmp.at(i).mid(1);
+        s.description = title + " (" + s.command + " " + s.parameter + ")";
+
+        emit recievedEEPROMSetting(s);
+    }
+
+    EEPROMGroup++;
+}
+
 void Parser::parse(QByteArray data)
 {
     if(!data.isEmpty())
     {
-        if(readingFiles)
+        if(readingFiles && !data.startsWith("ok")) //An "ok" can come in between, it is never a file
         {
-            if(!data.contains("End file list")) SDFilesList.append(data);
+            if(!data.contains("End file list"))
+            {
+                SDFile f = parseSDFile(data);
+                if(!f.name.isEmpty()) emit recievedSDFile(f); //Listing is shown as it arrives
+            }
             else
             {
                 readingFiles = false;
-                emit recievedSDFilesList(SDFilesList);
+                emit recievedSDFilesEnd();
             }
             return;
         }
@@ -42,7 +158,8 @@ void Parser::parse(QByteArray data)
             {
                 if(data.startsWith("EPR"))
                 {
-                    emit recievedEEPROMLine(QString(data));
+                    EEPROMSetting s = parseRepetierEEPROM(data);
+                    if(!s.value.isEmpty()) emit recievedEEPROMSetting(s);
                     EEPROMReadingStarted = true;
                 }
                 else if(EEPROMReadingStarted)
@@ -54,6 +171,22 @@ void Parser::parse(QByteArray data)
 
                 return;
             }
+            else if(firmware == Marlin)
+            {
+                if(data.startsWith("echo:"))
+                {
+                    parseMarlinEEPROM(data);
+                    EEPROMReadingStarted = true;
+                    return;
+                }
+                else if(EEPROMReadingStarted && data.startsWith("ok")) //M503 is over, "ok T:" still goes on below
+                {
+                    readingEEPROM = false;
+                    EEPROMReadingStarted = false;
+                    EEPROMComment.clear();
+                    emit recievingEEPROMDone();
+                }
+            }
         }
 
         /*
@@ -65,14 +198,20 @@ void Parser::parse(QByteArray data)
             else emit recievedOkNum(0);
         }
         */
-        else if(data.startsWith("T:") || data.startsWith("ok T:"))
+        if(data.startsWith("T:") || data.startsWith("ok T:") || data.startsWith(" T:")) //Leading space is used by autoreport
         {
             TemperatureReadings r;
+            QString line(data);
 
-            if(temperatureRegxp.indexIn(QString(data)) != -1)
+            int bedPos = line.indexOf("B:"); //Marlin puts target temperature between readings
+
+            if(temperatureRegxp.indexIn(line) != -1)
+            {
                 r.e = temperatureRegxp.cap(0).toDouble();
+                if(bedPos == -1) bedPos = temperatureRegxp.pos(0) + temperatureRegxp.matchedLength();
+            }
             else r.e = 0;
-            if(temperatureRegxp.indexIn(QString(data), temperatureRegxp.matchedLength()) != -1)
+            if(bedPos != -1 && temperatureRegxp.indexIn(line, bedPos) != -1)
                 r.b = temperatureRegxp.cap(0).toDouble();
             else r.b = 0;
 
@@ -82,7 +221,7 @@ void Parser::parse(QByteArray data)
         }
         //else if(data.startsWith("wait")) emit recievedOkWait();
         else if(data.startsWith("rs") || data.startsWith("Resend"))
-            emit recievedResend(data.split(' ').at(0).toInt());
+            emit recievedResend(resendLine(data));
         else if(data.startsWith("!!")) emit recievedError();
         else if(data.startsWith("Done")) emit recievedSDDone();
         else if(data.startsWith("start")) emit recievedStart();
@@ -114,10 +253,15 @@ void Parser::parse(QByteArray data)
 
         }
         else if(data.startsWith("Not SD "));
+        else if(data.startsWith("Cap:")) //M115 capability report, like Cap:AUTOREPORT_TEMP:1
+        {
+            QList<QByteArray> cap = data.trimmed().split(':');
+            if(cap.size() == 3) emit recievedCapability(QString(cap.at(1)), cap.at(2).toInt());
+        }
         else if(data.contains("Begin file list"))
         {
-            SDFilesList.clear();
             readingFiles = true; //start reading files from SD
+            emit recievedSDFilesBegin();
         }
         //else if(data.contains("REPETIER")) emit recievedFirmware(Repetier);
         //else if(data.contains("MARLIN")) emit recievedFirmware(Marlin);
@@ -128,4 +272,12 @@ void Parser::parse(QByteArray data)
 void Parser::setEEPROMReadingMode()
 {
     readingEEPROM = true;
+    EEPROMReadingStarted = false;
+    EEPROMGroup = 0;
+    EEPROMComment.clear();
+}
+
+void Parser::setFirmware(int firmware)
+{
+    this->firmware = firmware;
 }
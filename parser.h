@@ -2,7 +2,8 @@
 #define PARSETHREAD_H
 
 #include <QThread>
-#include <QSettings>
+#include <QRegExp>
+#include <QStringList>
 
 #include "repraptor.h"
 
@@ -16,21 +17,30 @@ public:
     explicit Parser(QObject *parent = 0);
     ~Parser();
 
+    static int resendLine(const QByteArray &data);
+
 protected:
     QByteArray data;
-    QStringList SDFilesList;
     int firmware;
     bool readingFiles;
     bool readingEEPROM;
     bool EEPROMReadingStarted;
+    int EEPROMGroup;
+    QString EEPROMComment;
     QRegExp temperatureRegxp;
 
+    SDFile parseSDFile(const QByteArray &data);
+    EEPROMSetting parseRepetierEEPROM(const QByteArray &data);
+    void parseMarlinEEPROM(const QByteArray &data);
+
 signals:
     void recievedTemperature(TemperatureReadings);
     void recievedSDUpdate(SDProgress);
-    void recievedEEPROMLine(QString);
+    void recievedEEPROMSetting(EEPROMSetting);
     void recievingEEPROMDone();
-    void recievedSDFilesList(QStringList);
+    void recievedSDFilesBegin();
+    void recievedSDFile(SDFile);
+    void recievedSDFilesEnd();
     void recievedOkWait();
     void recievedOkNum(int);
     void recievedStart();
@@ -38,10 +48,12 @@ signals:
     void recievedError();
     void recievedFirmware(int);
     void recievedSDDone();
+    void recievedCapability(QString, bool);
 
 public slots:
     void parse(QByteArray data);
     void setEEPROMReadingMode();
+    void setFirmware(int firmware);
 };
 
 #endif // PARSETHREAD_H
@@ -0,0 +1,121 @@
+#include "portwatcher.h"
+
+PortWatcher::PortWatcher(QObject *parent) :
+    QObject(parent)
+{
+    listedOnce = false;
+    again = false;
+    settleTimer.setSingleShot(true);
+    settleTimer.setInterval(300);
+    connect(&lister, SIGNAL(finished()), this, SLOT(listed()));
+    connect(&pollTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+    connect(&settleTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+    connect(&devices, SIGNAL(directoryChanged(QString)), this, SLOT(devicesChanged()));
+}
+
+PortWatcher::~PortWatcher()
+{
+    lister.waitForFinished();
+}
+
+void PortWatcher::start(int interval)
+{
+    watchDevices();
+    if(!isWatchingDevices()) pollTimer.start(interval); //No device events here, fall back to polling
+    refresh();
+}
+
+void PortWatcher::watchDevices()
+{
+#ifdef Q_OS_LINUX
+    //by-id appears with the first USB serial device, /dev tells when it does
+    QStringList paths;
+    paths << "/dev" << "/dev/serial/by-id";
+    foreach(const QString &path, paths)
+        if(!devices.directories().contains(path) && QDir(path).exists()) devices.addPath(path);
+#endif
+}
+
+void PortWatcher::devicesChanged()
+{
+    //udev creates the node, then the links and permissions, so wait for it to finish
+    watchDevices();
+    settleTimer.start();
+}
+
+void PortWatcher::refresh()
+{
+    if(lister.isRunning())
+    {
+        again = true;
+        return;
+    }
+
+    lister.setFuture(QtConcurrent::run(QSerialPortInfo::availablePorts));
+}
+
+void PortWatcher::listed()
+{
+    QList<QSerialPortInfo> ports = lister.result();
+
+    if(!listedOnce || !sameNames(ports, known))
+    {
+        QList<QSerialPortInfo> before = known;
+        bool first = !listedOnce;
+
+        listedOnce = true;
+        known = ports;
+        emit portsChanged();
+
+        foreach(const QSerialPortInfo &info, ports)
+        {
+            bool isNew = first;
+            if(!isNew)
+            {
+                isNew = true;
+                foreach(const QSerialPortInfo &old, before)
+                    if(old.portName() == info.portName()) isNew = false;
+            }
+            if(isNew) emit portArrived(info);
+        }
+    }
+
+    if(again) //Something changed while listing, the result may be stale
+    {
+        again = false;
+        refresh();
+    }
+}
+
+QString PortWatcher::identity(const QSerialPortInfo &info)
+{
+    QString id;
+    if(info.hasVendorIdentifier() && info.hasProductIdentifier())
+        id = QString("%1:%2").arg(info.vendorIdentifier(), 4, 16, QChar('0'))
+                .arg(info.productIdentifier(), 4, 16, QChar('0'));
+    if(!info.serialNumber().isEmpty()) return id + " " + info.serialNumber();
+    if(!id.isEmpty()) return id; //Boards without a serial number, one of a kind is the best we can do
+    return info.portName();
+}
+
+QString PortWatcher::uniqueIdentity(const QSerialPortInfo &info)
+{
+    if(!info.serialNumber().isEmpty()) return identity(info);
+
+#ifdef Q_OS_LINUX
+    //Clones without a serial number are still told apart by the USB socket they are in
+    QString device = QFileInfo(info.systemLocation()).canonicalFilePath();
+    foreach(const QFileInfo &link, QDir("/dev/serial/by-path").entryInfoList(QDir::System | QDir::Files))
+        if(link.canonicalFilePath() == device) return link.absoluteFilePath();
+#endif
+
+    return QString();
+}
+
+bool PortWatcher::sameNames(const QList<QSerialPortInfo> &a, const QList<QSerialPortInfo> &b)
+{
+    if(a.size() != b.size()) return false;
+    for(int i = 0; i < a.size(); i++)
+        if(a.at(i).portName() != b.at(i).portName()) return false;
+    return true;
+}
@@ -0,0 +1,59 @@
+#ifndef PORTWATCHER_H
+#define PORTWATCHER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QList>
+#include <QDir>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrent>
+#include <QtSerialPort/QSerialPortInfo>
+
+//Lists serial ports off the GUI thread, which can take a while on
+//hosts with many ttys, and tells when the list changed.
+//On Linux device nodes are watched with inotify, elsewhere it polls
+//slowly to notice hotplug. refresh() asks right away.
+class PortWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PortWatcher(QObject *parent = 0);
+    ~PortWatcher();
+
+    void start(int interval = 2000);
+    inline QList<QSerialPortInfo> ports() const { return known; }
+    inline bool isWatchingDevices() const { return !devices.directories().isEmpty(); }
+
+    //Stays the same when the printer comes back under another device name,
+    //but boards without a serial number all share their VID:PID
+    static QString identity(const QSerialPortInfo &info);
+    //Tells one board from all others, empty if nothing does
+    static QString uniqueIdentity(const QSerialPortInfo &info);
+
+public slots:
+    void refresh();
+
+signals:
+    void portsChanged();
+    void portArrived(const QSerialPortInfo &info); //Also for every port of the first listing
+
+protected:
+    QFutureWatcher< QList<QSerialPortInfo> > lister;
+    QTimer pollTimer;
+    QTimer settleTimer;
+    QFileSystemWatcher devices;
+    QList<QSerialPortInfo> known;
+    bool listedOnce;
+    bool again;         //Refresh asked while a listing was running
+
+    void watchDevices();
+    static bool sameNames(const QList<QSerialPortInfo> &a, const QList<QSerialPortInfo> &b);
+
+protected slots:
+    void listed();
+    void devicesChanged();
+};
+
+#endif // PORTWATCHER_H
@@ -0,0 +1,30 @@
+#!/bin/sh
+#Replays every transcript through the parser and compares the signals with
+#its golden dump. The firmware is the part of the name before the first '-'.
+#Usage: check.sh [path/to/repraptor-replay] [-u]
+#-u rewrites the golden dumps, review the diff before committing them
+
+replay=${1:-./repraptor-replay}
+dir=$(dirname "$0")/transcripts
+failed=0
+
+for transcript in "$dir"/*.txt
+do
+    name=$(basename "$transcript" .txt)
+    firmware=${name%%-*}
+
+    if [ "$2" = "-u" ]
+    then
+        "$replay" -f "$firmware" -t -n -g "$dir/$name.golden" -u "$transcript" || failed=1
+        continue
+    fi
+
+    "$replay" -f "$firmware" -t -n -g "$dir/$name.golden" "$transcript"
+    case $? in
+        0) echo "PASS $name" ;;
+        2) echo "FAIL $name"; failed=1 ;;
+        *) echo "ERROR $name"; failed=1 ;;
+    esac
+done
+
+exit $failed
@@ -0,0 +1,289 @@
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QFile>
+
+#include "parser.h"
+#include "wirelogger.h"
+
+static QTextStream err(stderr);
+
+//Plain transcripts are easier to keep next to the code than wire logs:
+//every line is something the firmware said, unless it starts with "> "
+//which marks a line the host sent
+static bool readTranscript(const QString &filename, QList<WireLogger::Record> &records)
+{
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly)) return false;
+
+    qint64 n = 0;
+    foreach(QByteArray l, file.readAll().split('\n'))
+    {
+        if(l.endsWith('\r')) l.chop(1);
+
+        WireLogger::Record r;
+        r.time = n++;
+        if(l.startsWith("> "))
+        {
+            r.direction = WireLogger::Sent;
+            r.line = l.mid(2);
+        }
+        else
+        {
+            r.direction = WireLogger::Recieved;
+            r.line = l;
+        }
+        records.append(r);
+    }
+    if(!records.isEmpty() && records.last().line.isEmpty()) records.removeLast(); //Trailing newline
+
+    return true;
+}
+
+static void feed(Parser &parser, const WireLogger::Record &r)
+{
+    if(r.direction == WireLogger::Recieved) parser.parse(r.line + '\n');
+    else if(r.line.contains("M503") || r.line.contains("M205"))
+        parser.setEEPROMReadingMode(); //Same as the main window does after asking
+}
+
+static void dumpSignals(Parser &parser, QTextStream &out)
+{
+    QObject::connect(&parser, &Parser::recievedTemperature, [&out](TemperatureReadings r)
+    { out << "  temperature " << r.e << " " << r.b << "\n"; });
+    QObject::connect(&parser, &Parser::recievedSDUpdate, [&out](SDProgress p)
+    { out << "  sd progress " << p.progress << "/" << p.total << "\n"; });
+    QObject::connect(&parser, &Parser::recievedEEPROMSetting, [&out](EEPROMSetting s)
+    { out << "  eeprom " << s.description << " = " << s.value << "\n"; });
+    QObject::connect(&parser, &Parser::recievingEEPROMDone, [&out]()
+    { out << "  eeprom done\n"; });
+    QObject::connect(&parser, &Parser::recievedSDFilesBegin, [&out]()
+    { out << "  sd files begin\n"; });
+    QObject::connect(&parser, &Parser::recievedSDFile, [&out](SDFile f)
+    {
+        out << "  sd file " << f.name << " " << f.size;
+        if(!f.longName.isEmpty()) out << " \"" << f.longName << "\"";
+        out << "\n";
+    });
+    QObject::connect(&parser, &Parser::recievedSDFilesEnd, [&out]()
+    { out << "  sd files end\n"; });
+    QObject::connect(&parser, &Parser::recievedOkWait, [&out]()
+    { out << "  ok\n"; });
+    QObject::connect(&parser, &Parser::recievedOkNum, [&out](int n)
+    { out << "  ok " << n << "\n"; });
+    QObject::connect(&parser, &Parser::recievedResend, [&out](int n)
+    { out << "  resend " << n << "\n"; });
+    QObject::connect(&parser, &Parser::recievedError, [&out]()
+    { out << "  error\n"; });
+    QObject::connect(&parser, &Parser::recievedStart, [&out]()
+    { out << "  start\n"; });
+    QObject::connect(&parser, &Parser::recievedFirmware, [&out](int fw)
+    { out << "  firmware " << fw << "\n"; });
+    QObject::connect(&parser, &Parser::recievedSDDone, [&out]()
+    { out << "  sd done\n"; });
+    QObject::connect(&parser, &Parser::recievedCapability, [&out](QString cap, bool enabled)
+    { out << "  capability " << cap << " " << enabled << "\n"; });
+}
+
+//Numbered lines may go back after a resend, but never past the next line
+//the firmware expects, M110 N<k> makes that N<k + 1>. The first line after
+//M110 has to be exactly that one, a job numbered from N0 after M110 N0
+//gets its first line refused and the resend skips it.
+static bool checkNumbering(const QList<WireLogger::Record> &records)
+{
+    bool ok = true;
+    long next = 1; //Firmware expects N1 after a reset
+    bool reset = false;
+
+    foreach(const WireLogger::Record &r, records)
+    {
+        if(r.direction != WireLogger::Sent) continue;
+
+        QByteArray line = r.line;
+        long number = -1;
+        if(line.startsWith('N'))
+        {
+            int end = 1;
+            while(end < line.size() && line.at(end) >= '0' && line.at(end) <= '9') end++;
+            number = line.mid(1, end - 1).toLong();
+            line = line.mid(end).trimmed();
+        }
+
+        if(line.startsWith("M110"))
+        {
+            int n = line.indexOf('N');
+            next = (n == -1 ? 0 : line.mid(n + 1).split(' ').first().split('*').first().toLong()) + 1;
+            reset = true;
+            continue;
+        }
+        if(number == -1) continue;
+
+        if(reset && number != next)
+        {
+            err << r.time << ": first line after M110 is N" << number << ", the firmware expects N" << next << "\n";
+            ok = false;
+        }
+        else if(number > next)
+        {
+            err << r.time << ": sent N" << number << " while the firmware expects N" << next << "\n";
+            ok = false;
+        }
+        next = qMax(next, number + 1);
+        reset = false;
+    }
+
+    return ok;
+}
+
+//Reports the first line that differs, which is usually enough to see what changed
+static bool compareGolden(const QString &filename, const QByteArray &dump)
+{
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        err << "Can't read " << filename << "\n";
+        return false;
+    }
+
+    QList<QByteArray> expected = file.readAll().split('\n');
+    QList<QByteArray> got = dump.split('\n');
+
+    for(int i = 0; i < qMax(expected.size(), got.size()); i++)
+    {
+        QByteArray e = i < expected.size() ? expected.at(i) : QByteArray("<end of file>");
+        QByteArray g = i < got.size() ? got.at(i) : QByteArray("<end of output>");
+        if(e == g) continue;
+
+        err << filename << ":" << i + 1 << ": output differs\n"
+            << "  expected: " << e << "\n"
+            << "  got:      " << g << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCoreApplication::setOrganizationName("NeoTheFox");
+    QCoreApplication::setApplicationName("RepRaptor");
+
+    QStringList args = a.arguments().mid(1);
+    int firmware = OtherFirmware;
+    bool transcript = false, update = false, numbering = false;
+    int rounds = 0;
+    QString golden;
+
+    while(!args.isEmpty() && args.first().startsWith('-'))
+    {
+        QString opt = args.takeFirst();
+        if(opt == "-t") transcript = true;
+        else if(opt == "-u") update = true;
+        else if(opt == "-n") numbering = true;
+        else if(opt == "-f" && !args.isEmpty())
+        {
+            QString name = args.takeFirst().toLower();
+            if(name == "marlin") firmware = Marlin;
+            else if(name == "repetier") firmware = Repetier;
+        }
+        else if(opt == "-g" && !args.isEmpty()) golden = args.takeFirst();
+        else if(opt == "-b" && !args.isEmpty()) rounds = args.takeFirst().toInt();
+        else
+        {
+            args.clear();
+            break;
+        }
+    }
+
+    if(args.isEmpty() || (update && golden.isEmpty()))
+    {
+        err << "Usage: repraptor-replay [-f marlin|repetier|other] [-t] [-n] [-g golden [-u]] [-b rounds] log...\n"
+            << "  -t  logs are plain transcripts, \"> \" marks sent lines\n"
+            << "  -n  check that sent line numbers never skip a line\n"
+            << "  -g  compare the signal dump with a golden file, -u rewrites it\n"
+            << "  -b  parse the received lines this many more times and report lines/s\n";
+        return 1;
+    }
+
+    QList<WireLogger::Record> records;
+    foreach(const QString &filename, args)
+    {
+        bool ok = transcript ? readTranscript(filename, records) : WireLogger::readFile(filename, records);
+        if(!ok)
+        {
+            err << "Can't read " << filename << "\n";
+            return 1;
+        }
+    }
+
+    //Parser is used directly in this thread, so every signal is seen right after its line
+    QByteArray dump;
+    {
+        QTextStream out(&dump);
+        Parser parser;
+        parser.setFirmware(firmware);
+        dumpSignals(parser, out);
+
+        foreach(const WireLogger::Record &r, records)
+        {
+            out << r.time << " " << r.direction << " " << r.line << "\n";
+            feed(parser, r);
+        }
+        out.flush();
+    }
+
+    int result = 0;
+    if(numbering && !checkNumbering(records)) result = 2;
+
+    if(update)
+    {
+        QFile file(golden);
+        if(!file.open(QIODevice::WriteOnly) || file.write(dump) != dump.size())
+        {
+            err << "Can't write " << golden << "\n";
+            return 1;
+        }
+    }
+    else if(!golden.isEmpty())
+    {
+        if(!compareGolden(golden, dump)) result = 2;
+    }
+    else if(!rounds)
+    {
+        QTextStream(stdout) << dump;
+    }
+
+    if(rounds > 0)
+    {
+        //Nothing is connected here, so this is the cost of parse() alone
+        Parser parser;
+        parser.setFirmware(firmware);
+
+        qint64 lines = 0, bytes = 0;
+        QElapsedTimer timer;
+        timer.start();
+        for(int i = 0; i < rounds; i++)
+        {
+            foreach(const WireLogger::Record &r, records)
+            {
+                feed(parser, r);
+                if(r.direction == WireLogger::Recieved)
+                {
+                    lines++;
+                    bytes += r.line.size() + 1;
+                }
+            }
+        }
+        double seconds = qMax<qint64>(timer.nsecsElapsed(), 1) / 1e9;
+
+        err << lines << " lines in " << seconds << " s, "
+            << qRound64(lines / seconds) << " lines/s, "
+            << bytes / seconds / 1e6 << " MB/s\n";
+    }
+
+    err.flush();
+    return result;
+}
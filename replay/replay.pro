@@ -0,0 +1,29 @@
+#-------------------------------------------------
+#
+# Replays RepRaptor wire logs through the parser
+# Licenced on terms of GNU GPL v2 licence
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+TARGET = repraptor-replay
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+INCLUDEPATH += ..
+
+SOURCES += main.cpp \
+    ../parser.cpp \
+    ../wirelogger.cpp
+
+HEADERS += ../parser.h \
+    ../repraptor.h \
+    ../wirelogger.h
+
+#make check replays the transcripts against their golden dumps
+check.commands = $$PWD/check.sh $$OUT_PWD/$$TARGET
+check.depends = $$TARGET
+QMAKE_EXTRA_TARGETS += check
@@ -15,19 +15,47 @@ namespace RepRaptor
     {
         Marlin,
         Repetier,
-        OtherFirmware
+        OtherFirmware,
+        AutoFirmware //Detected from M115 on connect
+    };
+
+    enum CommandLane
+    {
+        EmergencyLane, //Written immediately, ignores flow control
+        UserLane,
+        StatusLane     //Deduplicated status queries like M105 or M27
+    };
+
+    enum EEPROMType //Same as Repetier EPR types
+    {
+        EEPROMByte,
+        EEPROMInt,
+        EEPROMLong,
+        EEPROMFloat
     };
 
     typedef struct
     {
-        int T, P;
-        QString S;
-    } repetierEEPROMline;
+        int type;
+        int position;    //Repetier EEPROM address
+        int group;       //Marlin settings sharing one M503 command line
+        QString command; //Marlin command, like M92
+        QChar parameter; //Marlin parameter, like X
+        QString value;
+        QString description;
+    } EEPROMSetting;
 
     typedef struct
     {
         unsigned long int progress, total;
     } SDProgress;
+
+    typedef struct
+    {
+        QString name;     //Name to use with M23
+        QString longName; //Reported by some firmwares, may be empty
+        qint64 size;      //-1 if not reported
+    } SDFile;
 }
 
 #endif // REPRAPTOR_H
@@ -0,0 +1,89 @@
+#include "sdfilemodel.h"
+
+SDFileModel::SDFileModel(QObject *parent) :
+    QAbstractTableModel(parent)
+{
+
+}
+
+SDFileModel::~SDFileModel()
+{
+
+}
+
+int SDFileModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : files.size();
+}
+
+int SDFileModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant SDFileModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || index.row() >= files.size()) return QVariant();
+
+    const SDFile &f = files.at(index.row());
+
+    if(role == Qt::DisplayRole)
+    {
+        switch(index.column())
+        {
+        case NameColumn:
+            return f.name;
+        case SizeColumn:
+            return f.size >= 0 ? QVariant(f.size) : QVariant();
+        case LongNameColumn:
+            return f.longName;
+        }
+    }
+    else if(role == Qt::TextAlignmentRole && index.column() == SizeColumn)
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+
+    return QVariant();
+}
+
+QVariant SDFileModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if(orientation != Qt::Horizontal || role != Qt::DisplayRole) return QVariant();
+
+    switch(section)
+    {
+    case NameColumn:
+        return QString("Name");
+    case SizeColumn:
+        return QString("Bytes");
+    case LongNameColumn:
+        return QString("Long name");
+    }
+
+    return QVariant();
+}
+
+const SDFile &SDFileModel::file(int row) const
+{
+    return files.at(row);
+}
+
+int SDFileModel::find(const QString &name) const
+{
+    for(int i = 0; i < files.size(); i++)
+        if(!files.at(i).name.compare(name, Qt::CaseInsensitive)) return i;
+    return -1;
+}
+
+void SDFileModel::append(SDFile file)
+{
+    beginInsertRows(QModelIndex(), files.size(), files.size());
+    files.append(file);
+    endInsertRows();
+}
+
+void SDFileModel::clear()
+{
+    beginResetModel();
+    files.clear();
+    endResetModel();
+}
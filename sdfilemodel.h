@@ -0,0 +1,44 @@
+#ifndef SDFILEMODEL_H
+#define SDFILEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QVector>
+
+#include "repraptor.h"
+
+using namespace RepRaptor;
+
+//Files on the SD card, filled line by line while M20 output arrives
+class SDFileModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column
+    {
+        NameColumn,
+        SizeColumn,
+        LongNameColumn,
+        ColumnCount
+    };
+
+    explicit SDFileModel(QObject *parent = 0);
+    ~SDFileModel();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+
+    const SDFile &file(int row) const;
+    int find(const QString &name) const;
+
+public slots:
+    void append(SDFile file);
+    void clear();
+
+protected:
+    QVector<SDFile> files;
+};
+
+#endif // SDFILEMODEL_H
@@ -1,13 +1,20 @@
 #include "sdwindow.h"
 #include "ui_sdwindow.h"
 
-SDWindow::SDWindow(QStringList files, QWidget *parent) :
+SDWindow::SDWindow(SDFileModel *model, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::SDWindow)
 {
     ui->setupUi(this);
 
-    ui->fileslist->addItems(files);
+    //Rows show up and get sorted while the listing is still arriving
+    files = model;
+    sorted.setSourceModel(model);
+    sorted.setDynamicSortFilter(true);
+    sorted.setSortCaseSensitivity(Qt::CaseInsensitive);
+    ui->filesview->setModel(&sorted);
+    ui->filesview->sortByColumn(SDFileModel::NameColumn, Qt::AscendingOrder);
+    ui->label->setText("Reading files...");
 }
 
 SDWindow::~SDWindow()
@@ -15,13 +22,20 @@ SDWindow::~SDWindow()
     delete ui;
 }
 
+void SDWindow::listingFinished()
+{
+    ui->label->setText("Print file (" + QString::number(files->rowCount()) + " on card):");
+    ui->filesview->resizeColumnsToContents();
+}
+
 void SDWindow::on_buttonBox_accepted()
 {
-    emit fileSelected(ui->fileslist->currentItem()->text());
+    QModelIndex index = ui->filesview->currentIndex();
+    if(index.isValid()) emit fileSelected(files->file(sorted.mapToSource(index).row()));
 }
 
-void SDWindow::on_fileslist_doubleClicked(const QModelIndex &index)
+void SDWindow::on_filesview_doubleClicked(const QModelIndex &index)
 {
-    emit fileSelected(ui->fileslist->currentItem()->text());
+    emit fileSelected(files->file(sorted.mapToSource(index).row()));
     this->close();
 }
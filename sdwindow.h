@@ -2,6 +2,9 @@
 #define SDWINDOW_H
 
 #include <QDialog>
+#include <QSortFilterProxyModel>
+
+#include "sdfilemodel.h"
 
 namespace Ui {
 class SDWindow;
@@ -12,19 +15,24 @@ class SDWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit SDWindow(QStringList files, QWidget *parent = 0);
+    explicit SDWindow(SDFileModel *model, QWidget *parent = 0);
     ~SDWindow();
 
 signals:
-    void fileSelected(QString filename);
+    void fileSelected(SDFile file);
+
+public slots:
+    void listingFinished();
 
 private slots:
     void on_buttonBox_accepted();
 
-    void on_fileslist_doubleClicked(const QModelIndex &index);
+    void on_filesview_doubleClicked(const QModelIndex &index);
 
 private:
     Ui::SDWindow *ui;
+    SDFileModel *files;
+    QSortFilterProxyModel sorted;
 };
 
 #endif // SDWINDOW_H
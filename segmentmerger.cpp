@@ -0,0 +1,203 @@
+#include "segmentmerger.h"
+#include "lineencoder.h"
+
+#include <math.h>
+#include <string.h>
+
+static const int maxRunPoints = 64;     //Bounds the deviation check
+static const double ratioTolerance = 0.05;
+
+SegmentMerger::SegmentMerger(Limits limits)
+{
+    this->limits = limits;
+    inches = false;
+    runE = endE = runLength = runFeed = runDeviation = 0;
+    runHasFeed = false;
+    runAbsoluteE = true;
+    firstLength = 0;
+    restoreFeed = 0;
+    merged.before = merged.after = 0;
+    merged.deviation = 0;
+    points.reserve(maxRunPoints + 1);
+}
+
+GCodeStore::MergeStats SegmentMerger::stats() const
+{
+    return merged;
+}
+
+bool SegmentMerger::isCandidate(double x, double y) const
+{
+    //Plain absolute XY move, anything else ends the run
+    if(!command.is('G', 1) || inches || !(command.has('X') || command.has('Y')) || command.has('Z'))
+        return false;
+    for(char p = 'A'; p <= 'Z'; p++)
+        if(command.has(p) && p != 'X' && p != 'Y' && p != 'E' && p != 'F') return false;
+
+    return state.x != x || state.y != y;
+}
+
+void SegmentMerger::add(GCodeStore &out, const char *line, int length)
+{
+    double x = state.x, y = state.y, e = state.e;
+    bool absolute = state.absolute;
+
+    state.update(line, length);
+    if(!command.parse(line, length))
+    {
+        flush(out);
+        out.append(line, length);
+        return;
+    }
+    if(command.is('G', 20)) inches = true;
+    else if(command.is('G', 21)) inches = false;
+
+    double de = state.e - e;
+    double segment = hypot(state.x - x, state.y - y);
+
+    if(!absolute || de < 0 || !isCandidate(x, y))
+    {
+        flush(out);
+        if(restoreFeed > 0 && command.letter == 'G' && command.code >= 0 && command.code <= 3)
+        {
+            if(!command.has('F')) //Would run at the slowed feedrate
+            {
+                char buffer[32];
+                memcpy(buffer, "G1 F", 4);
+                out.append(buffer, 4 + formatFixed(buffer + 4, restoreFeed, 0));
+            }
+            restoreFeed = 0;
+        }
+        out.append(line, length);
+        return;
+    }
+
+    double deviation = 0;
+    if(!points.isEmpty() && state.feedrate == runFeed && state.absoluteE == runAbsoluteE
+            && joins(state.x, state.y, de, segment, &deviation))
+    {
+        Point p = {state.x, state.y};
+        points.append(p);
+        runE += de;
+        endE = state.e;
+        runLength += segment;
+        runDeviation = qMax(runDeviation, deviation);
+        return;
+    }
+
+    flush(out);
+    Point a = {x, y}, b = {state.x, state.y};
+    points.append(a);
+    points.append(b);
+    runE = de;
+    endE = state.e;
+    runLength = segment;
+    runFeed = state.feedrate;
+    runDeviation = 0;
+    runHasFeed = command.has('F');
+    runAbsoluteE = state.absoluteE;
+    firstLength = qMin(length, int(sizeof(first)));
+    memcpy(first, line, firstLength);
+}
+
+bool SegmentMerger::joins(double x, double y, double e, double length, double *deviation) const
+{
+    if(points.size() > maxRunPoints) return false;
+
+    //Same extrusion per mm, travel only joins travel
+    if((e > 0) != (runE > 0)) return false;
+    if(runE > 0)
+    {
+        double ratio = runE / runLength;
+        if(fabs(e / length - ratio) > ratio * ratioTolerance) return false;
+    }
+
+    //Every point of the run, including the current end, near the new move
+    Point a = points.first(), b = {x, y};
+    for(int i = 1; i < points.size(); i++)
+    {
+        double d = distance(points.at(i), a, b);
+        if(d > limits.deviation) return false;
+        *deviation = qMax(*deviation, d);
+    }
+    return true;
+}
+
+double SegmentMerger::distance(const Point &p, const Point &a, const Point &b)
+{
+    //To the segment, not the line, so runs that turn back are not joined
+    double dx = b.x - a.x, dy = b.y - a.y;
+    double squared = dx*dx + dy*dy;
+    double t = squared > 0 ? ((p.x - a.x)*dx + (p.y - a.y)*dy) / squared : 0;
+    t = qBound(0.0, t, 1.0);
+    return hypot(p.x - (a.x + t*dx), p.y - (a.y + t*dy));
+}
+
+void SegmentMerger::flush(GCodeStore &out)
+{
+    if(points.isEmpty()) return;
+
+    int segments = points.size() - 1;
+    merged.before += segments;
+    merged.after++;
+    merged.deviation = qMax(merged.deviation, runDeviation);
+
+    const Point &a = points.first(), &b = points.last();
+    double chord = hypot(b.x - a.x, b.y - a.y);
+    double feed = runFeed;
+    bool slowed = false;
+    if(limits.maxRate > 0 && feed > 0 && chord > 0 && chord / (feed / 60) < 1 / limits.maxRate)
+    {
+        feed = qMax(1.0, chord * limits.maxRate * 60);
+        slowed = true;
+    }
+
+    if(segments == 1 && !slowed && restoreFeed == 0) out.append(first, firstLength);
+    else
+    {
+        //Written here instead of qsnprintf, which follows the locale
+        char buffer[128];
+        char *p = buffer;
+        memcpy(p, "G1 X", 4); p += 4;
+        p += formatFixed(p, b.x, 3);
+        memcpy(p, " Y", 2); p += 2;
+        p += formatFixed(p, b.y, 3);
+        if(runE != 0)
+        {
+            memcpy(p, " E", 2); p += 2;
+            p += formatFixed(p, runAbsoluteE ? endE : runE, 5);
+        }
+        if(slowed || runHasFeed || restoreFeed > 0)
+        {
+            memcpy(p, " F", 2); p += 2;
+            p += formatFixed(p, feed, 0);
+        }
+        out.append(buffer, p - buffer);
+    }
+
+    restoreFeed = slowed ? runFeed : 0;
+    points.resize(0);
+}
+
+int SegmentMerger::formatFixed(char *out, double value, int decimals)
+{
+    char *p = out;
+    quint64 scale = 1;
+    for(int i = 0; i < decimals; i++) scale *= 10;
+
+    quint64 scaled = quint64(fabs(value) * scale + 0.5);
+    if(value < 0 && scaled) *p++ = '-';
+    p += LineEncoder::formatNumber(p, quint32(scaled / scale));
+    if(decimals)
+    {
+        quint64 fraction = scaled % scale;
+        *p++ = '.';
+        for(int i = decimals - 1; i >= 0; i--)
+        {
+            p[i] = '0' + fraction % 10;
+            fraction /= 10;
+        }
+        p += decimals;
+    }
+    return p - out;
+}
@@ -0,0 +1,63 @@
+#ifndef SEGMENTMERGER_H
+#define SEGMENTMERGER_H
+
+#include <QVector>
+
+#include "gcodestore.h"
+#include "gcodecommand.h"
+#include "machinestate.h"
+
+//Joins runs of short, nearly straight G1 moves into one move while a file
+//is loaded, for boards whose planner starves on many tiny segments.
+//Every point of a run stays within the deviation of the joined move and
+//extrudes at the same rate. Moves still too short for the segment rate
+//limit are slowed down instead of being bent further.
+class SegmentMerger
+{
+public:
+    typedef struct
+    {
+        bool enabled;
+        double deviation;   //mm
+        double maxRate;     //Segments per second, 0 for no limit
+    } Limits;
+
+    SegmentMerger(Limits limits);
+
+    void add(GCodeStore &out, const char *line, int length);
+    void flush(GCodeStore &out);
+    GCodeStore::MergeStats stats() const;
+
+protected:
+    typedef struct
+    {
+        double x, y;
+    } Point;
+
+    Limits limits;
+    MachineState state;
+    GCodeCommand command;
+    bool inches;
+
+    //Run waiting to be written
+    QVector<Point> points;  //Start, then the end of every segment
+    double runE;            //Extrusion of the run
+    double endE;            //Absolute E after it
+    double runLength;
+    double runFeed;         //mm/min
+    double runDeviation;
+    bool runHasFeed;
+    bool runAbsoluteE;
+    char first[4096];       //First segment, written as it is if nothing joins it
+    int firstLength;
+
+    double restoreFeed;     //Feedrate to put back after a slowed move, 0 if none
+    GCodeStore::MergeStats merged;
+
+    bool isCandidate(double x, double y) const;
+    bool joins(double x, double y, double e, double length, double *deviation) const;
+    static double distance(const Point &p, const Point &a, const Point &b);
+    static int formatFixed(char *out, double value, int decimals);
+};
+
+#endif // SEGMENTMERGER_H
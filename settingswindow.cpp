@@ -14,15 +14,32 @@ SettingsWindow::SettingsWindow(QWidget *parent) :
     ui->statusbox->setValue(settings.value("core/statusinterval", 2000).toInt());
     ui->bedxbox->setValue(settings.value("printer/bedx", 200).toInt());
     ui->bedybox->setValue(settings.value("printer/bedy", 200).toInt());
+    ui->maxetmpbox->setValue(settings.value("printer/maxextrudertemp", 275).toInt());
+    ui->maxbtmpbox->setValue(settings.value("printer/maxbedtemp", 120).toInt());
     ui->lockbox->setChecked(settings.value("core/lockcontrols", 0).toBool());
     ui->checksumbox->setChecked(settings.value("core/checksums", 0).toBool());
     ui->sdbox->setChecked(settings.value("core/checksdstatus", 1).toBool());
+    ui->wirelogbox->setChecked(settings.value("core/wirelog", 0).toBool());
+    ui->apibox->setChecked(settings.value("core/controlserver", 0).toBool());
+    ui->reconnectbox->setChecked(settings.value("core/autoreconnect", 1).toBool());
+    ui->autoconnectbox->setChecked(settings.value("core/autoconnect", 0).toBool());
+    ui->smartpausebox->setChecked(settings.value("printer/smartpause", 1).toBool());
+    ui->retractbox->setValue(settings.value("printer/pauseretract", 2).toDouble());
+    ui->liftbox->setValue(settings.value("printer/pauselift", 5).toDouble());
+    ui->parkxbox->setValue(settings.value("printer/parkx", 0).toInt());
+    ui->parkybox->setValue(settings.value("printer/parky", 0).toInt());
+    ui->jobendedit->setPlainText(settings.value("printer/jobend").toString());
+    ui->jobstartedit->setPlainText(settings.value("printer/jobstart").toString());
+    ui->mergebox->setChecked(settings.value("printer/mergesegments", 0).toBool());
+    ui->deviationbox->setValue(settings.value("printer/mergedeviation", 0.02).toDouble());
+    ui->segmentratebox->setValue(settings.value("printer/maxsegmentrate", 0).toInt());
 
     ui->firmwarecombo->addItem("Marlin"); //0
     ui->firmwarecombo->addItem("Repetier"); //1
     ui->firmwarecombo->addItem("Other"); //2
+    ui->firmwarecombo->addItem("Detect on connect"); //3
 
-    ui->firmwarecombo->setCurrentIndex(settings.value("printer/firmware", OtherFirmware).toInt());
+    ui->firmwarecombo->setCurrentIndex(settings.value("printer/firmware", AutoFirmware).toInt());
 
     #ifdef QT_DEBUG
     ui->checksumbox->setEnabled(true);
@@ -43,9 +60,25 @@ void SettingsWindow::on_buttonBox_accepted()
     settings.setValue("core/statusinterval", ui->statusbox->value());
     settings.setValue("printer/bedy", ui->bedybox->value());
     settings.setValue("printer/bedx", ui->bedxbox->value());
+    settings.setValue("printer/maxextrudertemp", ui->maxetmpbox->value());
+    settings.setValue("printer/maxbedtemp", ui->maxbtmpbox->value());
     settings.setValue("core/echo", ui->echobox->isChecked());
     settings.setValue("core/lockcontrols", ui->lockbox->isChecked());
     settings.setValue("core/checksums", ui->checksumbox->isChecked());
     settings.setValue("core/checksdstatus", ui->sdbox->isChecked());
+    settings.setValue("core/wirelog", ui->wirelogbox->isChecked());
+    settings.setValue("core/controlserver", ui->apibox->isChecked());
+    settings.setValue("core/autoreconnect", ui->reconnectbox->isChecked());
+    settings.setValue("core/autoconnect", ui->autoconnectbox->isChecked());
+    settings.setValue("printer/smartpause", ui->smartpausebox->isChecked());
+    settings.setValue("printer/pauseretract", ui->retractbox->value());
+    settings.setValue("printer/pauselift", ui->liftbox->value());
+    settings.setValue("printer/parkx", ui->parkxbox->value());
+    settings.setValue("printer/parky", ui->parkybox->value());
+    settings.setValue("printer/jobend", ui->jobendedit->toPlainText());
+    settings.setValue("printer/jobstart", ui->jobstartedit->toPlainText());
+    settings.setValue("printer/mergesegments", ui->mergebox->isChecked());
+    settings.setValue("printer/mergedeviation", ui->deviationbox->value());
+    settings.setValue("printer/maxsegmentrate", ui->segmentratebox->value());
     settings.setValue("printer/firmware", ui->firmwarecombo->currentIndex());
 }
@@ -0,0 +1,24 @@
+#include "startupprofile.h"
+
+#include <QElapsedTimer>
+#include <stdio.h>
+
+static QElapsedTimer startupClock;
+
+void StartupProfile::enable()
+{
+    startupClock.start();
+}
+
+bool StartupProfile::isEnabled()
+{
+    return startupClock.isValid();
+}
+
+void StartupProfile::mark(const char *step)
+{
+    if(!startupClock.isValid()) return;
+
+    fprintf(stderr, "startup %8.1f ms  %s\n", startupClock.nsecsElapsed() / 1000000.0, step);
+    fflush(stderr);
+}
@@ -0,0 +1,13 @@
+#ifndef STARTUPPROFILE_H
+#define STARTUPPROFILE_H
+
+//Time since main() of the steps of a cold start, printed to stderr
+//when RepRaptor is run with --startup-profile.
+namespace StartupProfile
+{
+    void enable();
+    bool isEnabled();
+    void mark(const char *step);
+}
+
+#endif // STARTUPPROFILE_H
@@ -0,0 +1,183 @@
+#include "telemetry.h"
+
+#include <math.h>
+
+TimeEstimator::TimeEstimator(double acceleration)
+{
+    this->acceleration = acceleration;
+    seconds = 0;
+}
+
+void TimeEstimator::add(const char *line, int length)
+{
+    double x = state.x, y = state.y, z = state.z, e = state.e;
+
+    state.update(line, length);
+    if(!command.parse(line, length) || command.letter != 'G') return;
+
+    if(command.code == 4) //Dwell, P in milliseconds or S in seconds
+    {
+        if(command.has('P')) seconds += command.value('P') / 1000;
+        else if(command.has('S')) seconds += command.value('S');
+        return;
+    }
+    if(command.code < 0 || command.code > 3) return;
+
+    double dx = state.x - x, dy = state.y - y, dz = state.z - z;
+    double distance = sqrt(dx*dx + dy*dy + dz*dz);
+    if(distance == 0) distance = qAbs(state.e - e); //Retract or prime
+    if(distance == 0 || state.feedrate <= 0) return;
+
+    //Trapezoid if the move is long enough to reach the feedrate, triangle otherwise
+    double speed = state.feedrate / 60;
+    if(distance >= speed*speed / acceleration) seconds += distance / speed + speed / acceleration;
+    else seconds += 2 * sqrt(distance / acceleration);
+}
+
+void TimeEstimator::estimate(GCodeStore &gcode)
+{
+    TimeEstimator estimator;
+    QVector<GCodeStore::Mark> marks = gcode.marks();
+    int m = 0;
+
+    for(int i = 0; i < gcode.size(); i++)
+    {
+        while(m < marks.size() && marks.at(m).line <= i) marks[m++].time = estimator.elapsed();
+        estimator.add(gcode.line(i), gcode.length(i));
+    }
+    while(m < marks.size()) marks[m++].time = estimator.elapsed();
+
+    gcode.setMarks(marks);
+    gcode.setDuration(estimator.elapsed());
+}
+
+PrintTelemetry::PrintTelemetry()
+{
+    layer = span = -1;
+    lines = lastLine = 0;
+    estimated = actual = 0;
+    finished = false;
+}
+
+void PrintTelemetry::start(const GCodeStore &gcode)
+{
+    const QVector<GCodeStore::Mark> &marks = gcode.marks();
+    QHash<QByteArray, int> known;
+    double lastLayer = 0, lastType = 0;
+
+    layers.clear();
+    features.clear();
+    spans.clear();
+    layer = span = -1;
+    lines = gcode.size();
+    lastLine = 0;
+    estimated = gcode.duration();
+    actual = 0;
+    finished = false;
+    clock.invalidate();
+
+    //Estimates of a section are the time up to the next mark of the same kind
+    for(int i = 0; i < marks.size(); i++)
+    {
+        const GCodeStore::Mark &m = marks.at(i);
+        if(m.kind == GCodeStore::LayerMark)
+        {
+            if(!layers.isEmpty()) layers.last().estimated = m.time - lastLayer;
+            Section s;
+            s.name = QString::fromLatin1(m.name);
+            s.first = m.line;
+            s.estimated = s.actual = 0;
+            layers.append(s);
+            lastLayer = m.time;
+        }
+        else if(m.kind == GCodeStore::TypeMark)
+        {
+            if(!spans.isEmpty()) features[spans.last().feature].estimated += m.time - lastType;
+            Span sp;
+            sp.first = m.line;
+            sp.feature = known.value(m.name, -1);
+            if(sp.feature == -1)
+            {
+                Section s;
+                s.name = QString::fromLatin1(m.name);
+                s.first = m.line;
+                s.estimated = s.actual = 0;
+                sp.feature = features.size();
+                known.insert(m.name, sp.feature);
+                features.append(s);
+            }
+            spans.append(sp);
+            lastType = m.time;
+        }
+    }
+    if(!layers.isEmpty()) layers.last().estimated = estimated - lastLayer;
+    if(!spans.isEmpty()) features[spans.last().feature].estimated += estimated - lastType;
+}
+
+bool PrintTelemetry::acknowledged(long line)
+{
+    double seconds = clock.isValid() ? clock.nsecsElapsed() / 1e9 : 0;
+    clock.start();
+
+    while(layer + 1 < layers.size() && layers.at(layer + 1).first <= line) layer++;
+    while(span + 1 < spans.size() && spans.at(span + 1).first <= line) span++;
+
+    actual += seconds;
+    if(layer >= 0) layers[layer].actual += seconds;
+    if(span >= 0) features[spans.at(span).feature].actual += seconds;
+    lastLine = line;
+
+    if(!finished && line + 1 >= lines) return finished = true;
+    else return false;
+}
+
+void PrintTelemetry::hold()
+{
+    clock.invalidate();
+}
+
+QString PrintTelemetry::layerString() const
+{
+    if(layer < 0) return layers.isEmpty() ? QString() : "Layer -/" + QString::number(layers.size());
+
+    const Section &s = layers.at(layer);
+    long end = layer + 1 < layers.size() ? layers.at(layer + 1).first : lines;
+    int percent = end > s.first ? (lastLine - s.first) * 100 / (end - s.first) : 100;
+
+    return "Layer " + QString::number(layer + 1) + "/" + QString::number(layers.size())
+            + ", " + QString::number(percent) + "%, "
+            + formatTime(s.actual) + "/" + formatTime(s.estimated);
+}
+
+QString PrintTelemetry::summary() const
+{
+    QString text = "Print took " + formatTime(actual) + ", estimated " + formatTime(estimated);
+    if(!layers.isEmpty()) text += ", " + QString::number(layers.size()) + " layers";
+    return text + "\n";
+}
+
+bool PrintTelemetry::exportCsv(const QString &filename) const
+{
+    QFile file(filename);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
+
+    QTextStream out(&file);
+    out << "section,name,first line,estimated s,actual s\n";
+    out << "file,," << 0 << "," << estimated << "," << actual << "\n";
+    for(int i = 0; i < layers.size(); i++)
+        out << "layer," << layers.at(i).name << "," << layers.at(i).first << ","
+            << layers.at(i).estimated << "," << layers.at(i).actual << "\n";
+    for(int i = 0; i < features.size(); i++)
+        out << "type," << features.at(i).name << ",," //Spread over the file
+            << features.at(i).estimated << "," << features.at(i).actual << "\n";
+
+    return out.status() == QTextStream::Ok;
+}
+
+QString PrintTelemetry::formatTime(double seconds)
+{
+    int s = qRound(seconds);
+    QString text = QString::number(s % 60).rightJustified(2, '0');
+    if(s < 3600) return QString::number(s / 60) + ":" + text;
+    return QString::number(s / 3600) + ":" + QString::number(s / 60 % 60).rightJustified(2, '0') + ":" + text;
+}
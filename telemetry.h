@@ -0,0 +1,79 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QFile>
+#include <QTextStream>
+#include <QElapsedTimer>
+
+#include "gcodestore.h"
+#include "gcodecommand.h"
+#include "machinestate.h"
+
+//Rough print time of a file: moves at their feedrate with a constant
+//acceleration, dwells as written. Heating and lookahead are ignored.
+class TimeEstimator
+{
+public:
+    TimeEstimator(double acceleration = 1500);
+
+    void add(const char *line, int length);
+    inline double elapsed() const { return seconds; }
+
+    static void estimate(GCodeStore &gcode); //Fills in the times of marks and the duration
+
+protected:
+    MachineState state;
+    GCodeCommand command;
+    double acceleration;
+    double seconds;
+};
+
+//Estimated and measured time of the layers and feature types
+//a slicer marked with ;LAYER: and ;TYPE: comments.
+//Time between two acknowledged lines goes to the sections of the later one.
+class PrintTelemetry
+{
+public:
+    PrintTelemetry();
+
+    void start(const GCodeStore &gcode);
+    bool acknowledged(long line); //True when the last line of the file is done
+    void hold();                  //Streaming stopped, the next gap is not counted
+    inline bool isEmpty() const { return layers.isEmpty() && features.isEmpty(); }
+    inline bool isFinished() const { return finished; }
+
+    QString layerString() const;
+    QString summary() const;
+    bool exportCsv(const QString &filename) const;
+
+    static QString formatTime(double seconds);
+
+protected:
+    typedef struct
+    {
+        QString name;
+        long first;         //Layers only, features are spread over the file
+        double estimated;
+        double actual;
+    } Section;
+
+    typedef struct
+    {
+        long first;
+        int feature;
+    } Span;
+
+    QVector<Section> layers;
+    QVector<Section> features;
+    QVector<Span> spans;
+    int layer, span;            //Current ones, -1 before the first mark
+    long lines, lastLine;
+    double estimated, actual;
+    bool finished;
+    QElapsedTimer clock;
+};
+
+#endif // TELEMETRY_H
@@ -0,0 +1,89 @@
+#include "temperaturegraph.h"
+
+TemperatureGraph::TemperatureGraph(QWidget *parent) : QWidget(parent)
+{
+    history = 0;
+    span = 0;
+
+    //New readings come in about once a second, no need to redraw faster
+    refresh.setInterval(1000);
+    refresh.start();
+
+    connect(&refresh, SIGNAL(timeout()), this, SLOT(update()));
+}
+
+TemperatureGraph::~TemperatureGraph()
+{
+
+}
+
+void TemperatureGraph::setHistory(const TemperatureHistory *h)
+{
+    history = h;
+    this->update();
+}
+
+void TemperatureGraph::setSpan(qint64 ms)
+{
+    span = ms;
+    this->update();
+}
+
+void TemperatureGraph::paintEvent(QPaintEvent *pe)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::white);
+
+    if(!history || history->isEmpty()) return;
+
+    QRect area = rect().adjusted(30, 8, -8, -18);
+    if(area.width() < 2 || area.height() < 2) return;
+
+    qint64 to = history->lastTime();
+    qint64 from = span > 0 ? to - span : history->firstTime();
+    if(span == PrintSpan && history->printStartTime()) from = qMax(from, history->printStartTime());
+    if(to <= from) to = from + 1;
+
+    //Only the buckets in the visible range are touched
+    int level = history->selectLevel(from, to, area.width());
+    QVector<TemperatureHistory::Bucket> buckets = history->buckets(level, from, to);
+
+    float top = 50;
+    foreach (const TemperatureHistory::Bucket &b, buckets)
+        top = qMax(top, qMax(b.eMax, b.bMax));
+    top = (int(top) / 50 + 1) * 50;
+
+    //Grid
+    painter.setPen(Qt::lightGray);
+    for(int t = 0; t <= top; t += 50)
+    {
+        int y = area.bottom() - t * area.height() / top;
+        painter.drawLine(area.left(), y, area.right(), y);
+        painter.drawText(0, y + 4, QString::number(t));
+    }
+    painter.setPen(Qt::darkGray);
+    painter.drawText(area.left(), height() - 4, "-" + QString::number((to - from) / 60000) + " min");
+    painter.drawText(area.right() - 25, height() - 4, "now");
+
+    QPolygonF eMax, eMin, bMax, bMin;
+    double xScale = double(area.width()) / (to - from);
+    double yScale = double(area.height()) / top;
+
+    foreach (const TemperatureHistory::Bucket &b, buckets)
+    {
+        double x = area.left() + qMax<qint64>(0, b.time - from) * xScale;
+
+        eMax.append(QPointF(x, area.bottom() - b.eMax * yScale));
+        eMin.append(QPointF(x, area.bottom() - b.eMin * yScale));
+        bMax.append(QPointF(x, area.bottom() - b.bMax * yScale));
+        bMin.append(QPointF(x, area.bottom() - b.bMin * yScale));
+    }
+
+    painter.setPen(Qt::red);
+    painter.drawPolyline(eMax);
+    if(level) painter.drawPolyline(eMin); //Raw samples have min == max
+
+    painter.setPen(Qt::blue);
+    painter.drawPolyline(bMax);
+    if(level) painter.drawPolyline(bMin);
+}
@@ -0,0 +1,32 @@
+#ifndef TEMPERATUREGRAPH_H
+#define TEMPERATUREGRAPH_H
+
+#include <QWidget>
+#include <QTimer>
+#include <QPainter>
+
+#include "temperaturehistory.h"
+
+class TemperatureGraph : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit TemperatureGraph(QWidget *parent = 0);
+    ~TemperatureGraph();
+    QTimer refresh;
+
+    void setHistory(const TemperatureHistory *h);
+
+    enum { PrintSpan = -1 };
+
+protected:
+    const TemperatureHistory *history;
+    qint64 span; //Visible time in ms, 0 shows everything, PrintSpan since the print started
+
+    virtual void paintEvent(QPaintEvent *pe);
+
+public slots:
+    void setSpan(qint64 ms);
+};
+
+#endif // TEMPERATUREGRAPH_H
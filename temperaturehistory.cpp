@@ -0,0 +1,169 @@
+#include "temperaturehistory.h"
+
+TemperatureHistory::TemperatureHistory()
+{
+    printStart = 0;
+    addLevel(0, 2048);          //Raw, about half an hour at 1 Hz
+    addLevel(10000, 1080);      //10 s buckets, 3 hours
+    addLevel(120000, 1440);     //2 min buckets, 2 days
+    addLevel(1200000, 2016);    //20 min buckets, 4 weeks
+}
+
+void TemperatureHistory::addLevel(qint64 width, int capacity)
+{
+    Level l;
+    l.width = width;
+    l.ring.resize(capacity);
+    l.head = 0;
+    l.count = 0;
+    l.hasPending = false;
+    l.wrapped = false;
+    levels.append(l);
+}
+
+void TemperatureHistory::append(qint64 time, double e, double b)
+{
+    Bucket sample;
+    sample.time = time;
+    sample.eMin = sample.eMax = e;
+    sample.bMin = sample.bMax = b;
+
+    push(levels[0], sample);
+
+    for(int i = 1; i < levels.size(); i++)
+    {
+        Level &l = levels[i];
+
+        if(l.hasPending && time >= l.pending.time + l.width)
+        {
+            push(l, l.pending);
+            l.hasPending = false;
+        }
+
+        if(!l.hasPending)
+        {
+            l.pending = sample;
+            l.pending.time = time - time % l.width; //Align buckets to their width
+            l.hasPending = true;
+        }
+        else merge(l.pending, sample);
+    }
+}
+
+void TemperatureHistory::clear()
+{
+    for(int i = 0; i < levels.size(); i++)
+    {
+        levels[i].head = 0;
+        levels[i].count = 0;
+        levels[i].hasPending = false;
+        levels[i].wrapped = false;
+    }
+    printStart = 0;
+}
+
+bool TemperatureHistory::isEmpty() const
+{
+    return levels.at(0).count == 0;
+}
+
+qint64 TemperatureHistory::firstTime() const
+{
+    //Coarsest non-empty level reaches furthest back
+    for(int i = levels.size() - 1; i >= 0; i--)
+    {
+        const Level &l = levels.at(i);
+        if(l.count) return at(l, 0).time;
+        if(l.hasPending) return l.pending.time;
+    }
+    return 0;
+}
+
+qint64 TemperatureHistory::lastTime() const
+{
+    const Level &l = levels.at(0);
+    if(!l.count) return 0;
+    return at(l, l.count - 1).time;
+}
+
+int TemperatureHistory::levelCount() const
+{
+    return levels.size();
+}
+
+int TemperatureHistory::selectLevel(qint64 from, qint64 to, int maxBuckets) const
+{
+    //Finest level that still has data for the whole range and is not
+    //denser than what can be drawn
+    for(int i = 0; i < levels.size(); i++)
+    {
+        const Level &l = levels.at(i);
+
+        if(l.wrapped && l.count && at(l, 0).time > from) continue;
+
+        int visible = l.count - lowerBound(l, from);
+        if(l.width) visible = qMin<qint64>(visible, (to - from) / l.width + 1);
+        if(visible <= maxBuckets) return i;
+    }
+
+    return levels.size() - 1;
+}
+
+QVector<TemperatureHistory::Bucket> TemperatureHistory::buckets(int level, qint64 from, qint64 to) const
+{
+    QVector<Bucket> result;
+    if(level < 0 || level >= levels.size()) return result;
+
+    const Level &l = levels.at(level);
+
+    for(int i = lowerBound(l, from); i < l.count; i++)
+    {
+        const Bucket &b = at(l, i);
+        if(b.time > to) return result;
+        result.append(b);
+    }
+
+    if(l.hasPending && l.pending.time <= to) result.append(l.pending);
+
+    return result;
+}
+
+void TemperatureHistory::push(Level &l, const Bucket &b)
+{
+    int capacity = l.ring.size();
+
+    l.ring[(l.head + l.count) % capacity] = b;
+
+    if(l.count < capacity) l.count++;
+    else
+    {
+        l.head = (l.head + 1) % capacity; //Overwrite the oldest one
+        l.wrapped = true;
+    }
+}
+
+const TemperatureHistory::Bucket &TemperatureHistory::at(const Level &l, int i) const
+{
+    return l.ring.at((l.head + i) % l.ring.size());
+}
+
+int TemperatureHistory::lowerBound(const Level &l, qint64 time) const
+{
+    //Buckets are stored in time order, so binary search works
+    int low = 0, high = l.count;
+    while(low < high)
+    {
+        int mid = (low + high) / 2;
+        if(at(l, mid).time + l.width < time) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+void TemperatureHistory::merge(Bucket &target, const Bucket &b)
+{
+    target.eMin = qMin(target.eMin, b.eMin);
+    target.eMax = qMax(target.eMax, b.eMax);
+    target.bMin = qMin(target.bMin, b.bMin);
+    target.bMax = qMax(target.bMax, b.bMax);
+}
@@ -0,0 +1,54 @@
+#ifndef TEMPERATUREHISTORY_H
+#define TEMPERATUREHISTORY_H
+
+#include <QVector>
+
+//Fixed size multi-resolution storage of temperature readings.
+//Level 0 keeps raw samples, every next level keeps min/max buckets
+//of a wider time span, so memory does not grow with print time.
+class TemperatureHistory
+{
+public:
+    typedef struct
+    {
+        qint64 time; //Start of the bucket in ms
+        float eMin, eMax, bMin, bMax;
+    } Bucket;
+
+    TemperatureHistory();
+
+    void append(qint64 time, double e, double b);
+    void clear();
+    bool isEmpty() const;
+    qint64 firstTime() const;
+    qint64 lastTime() const;
+    inline void markPrintStart(qint64 time) { printStart = time; }
+    inline qint64 printStartTime() const { return printStart; } //0 if nothing was printed
+
+
+    int levelCount() const;
+    int selectLevel(qint64 from, qint64 to, int maxBuckets) const;
+    QVector<Bucket> buckets(int level, qint64 from, qint64 to) const;
+
+protected:
+    typedef struct
+    {
+        qint64 width; //Bucket width in ms, 0 for raw samples
+        QVector<Bucket> ring;
+        int head, count;
+        Bucket pending;
+        bool hasPending;
+        bool wrapped;
+    } Level;
+
+    QVector<Level> levels;
+    qint64 printStart;
+
+    void addLevel(qint64 width, int capacity);
+    void push(Level &l, const Bucket &b);
+    const Bucket &at(const Level &l, int i) const; //i-th oldest bucket
+    int lowerBound(const Level &l, qint64 time) const;
+    static void merge(Bucket &target, const Bucket &b);
+};
+
+#endif // TEMPERATUREHISTORY_H
@@ -0,0 +1,28 @@
+#include "temperaturewindow.h"
+#include "ui_temperaturewindow.h"
+#include "temperaturegraph.h"
+
+TemperatureWindow::TemperatureWindow(const TemperatureHistory *history, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::TemperatureWindow)
+{
+    ui->setupUi(this);
+
+    ui->spanbox->addItem("This print", qint64(TemperatureGraph::PrintSpan));
+    ui->spanbox->addItem("Session", 0);
+    ui->spanbox->addItem("5 minutes", 5*60000);
+    ui->spanbox->addItem("30 minutes", 30*60000);
+    ui->spanbox->addItem("3 hours", 3*3600000);
+
+    ui->graph->setHistory(history);
+}
+
+TemperatureWindow::~TemperatureWindow()
+{
+    delete ui;
+}
+
+void TemperatureWindow::on_spanbox_currentIndexChanged(int index)
+{
+    ui->graph->setSpan(ui->spanbox->itemData(index).toLongLong());
+}
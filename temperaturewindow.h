@@ -0,0 +1,27 @@
+#ifndef TEMPERATUREWINDOW_H
+#define TEMPERATUREWINDOW_H
+
+#include <QDialog>
+
+#include "temperaturehistory.h"
+
+namespace Ui {
+class TemperatureWindow;
+}
+
+class TemperatureWindow : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit TemperatureWindow(const TemperatureHistory *history, QWidget *parent = 0);
+    ~TemperatureWindow();
+
+private slots:
+    void on_spanbox_currentIndexChanged(int index);
+
+private:
+    Ui::TemperatureWindow *ui;
+};
+
+#endif // TEMPERATUREWINDOW_H
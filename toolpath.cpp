@@ -0,0 +1,191 @@
+#include "toolpath.h"
+
+Toolpath::Toolpath(float extent)
+{
+    scale = extent * 4 / 65536; //Covers -2..2 times the bed size
+    zTop = 0;
+
+    lineIndex = 0;
+    lastSegmentLine = 0;
+    px = py = pz = pe = 0;
+    relative = false;
+    relativeE = false;
+    layerExtruded = false;
+}
+
+void Toolpath::reserve(int lines)
+{
+    //Every line produces at most one segment
+    xs.reserve(lines);
+    ys.reserve(lines);
+    steps.reserve(lines);
+}
+
+void Toolpath::addLine(const char *line, int length)
+{
+    GCodeCommand c;
+    quint32 index = lineIndex++;
+
+    if(!c.parse(line, length)) return;
+
+    if(c.letter == 'G')
+    {
+        switch(c.code)
+        {
+        case 0:
+        case 1:
+        case 2: //Arcs are shown as straight lines
+        case 3:
+        {
+            double x = px, y = py;
+            bool extrude = false;
+
+            if(c.has('X')) x = relative ? px + c.value('X') : c.value('X');
+            if(c.has('Y')) y = relative ? py + c.value('Y') : c.value('Y');
+            if(c.has('Z')) pz = relative ? pz + c.value('Z') : c.value('Z');
+            if(c.has('E'))
+            {
+                double e = relativeE ? pe + c.value('E') : c.value('E');
+                extrude = e > pe;
+                pe = e;
+            }
+
+            if(x != px || y != py)
+            {
+                px = x;
+                py = y;
+                addSegment(index, extrude);
+            }
+            break;
+        }
+        case 28:
+            if(!c.has('X') && !c.has('Y') && !c.has('Z')) px = py = pz = 0;
+            if(c.has('X')) px = 0;
+            if(c.has('Y')) py = 0;
+            if(c.has('Z')) pz = 0;
+            break;
+        case 90:
+            relative = false;
+            relativeE = false;
+            break;
+        case 91:
+            relative = true;
+            relativeE = true;
+            break;
+        case 92:
+            if(!c.has('X') && !c.has('Y') && !c.has('Z') && !c.has('E')) px = py = pz = pe = 0;
+            if(c.has('X')) px = c.value('X');
+            if(c.has('Y')) py = c.value('Y');
+            if(c.has('Z')) pz = c.value('Z');
+            if(c.has('E')) pe = c.value('E');
+            break;
+        }
+    }
+    else if(c.letter == 'M')
+    {
+        if(c.code == 82) relativeE = false;
+        else if(c.code == 83) relativeE = true;
+    }
+}
+
+void Toolpath::addSegment(quint32 line, bool extrude)
+{
+    if(extrude && (layers.isEmpty() || layers.last().z != float(pz)))
+    {
+        if(layers.isEmpty() || layerExtruded)
+        {
+            Layer l;
+            l.z = pz;
+            l.first = xs.size();
+            l.firstLine = line;
+            layers.append(l);
+        }
+        else layers.last().z = pz; //Layer had only travel moves so far
+        zTop = qMax(zTop, float(pz));
+    }
+    else if(layers.isEmpty())
+    {
+        Layer l;
+        l.z = pz;
+        l.first = 0;
+        l.firstLine = line;
+        layers.append(l);
+    }
+
+    if(extrude) layerExtruded = true;
+
+    //Large gaps between moves are split with zero length travel segments
+    quint32 step = xs.isEmpty() ? 0 : line - lastSegmentLine;
+    while(step > MaxStep)
+    {
+        xs.append(xs.isEmpty() ? 0 : xs.last());
+        ys.append(ys.isEmpty() ? 0 : ys.last());
+        steps.append(MaxStep);
+        step -= MaxStep;
+    }
+
+    xs.append(quantize(px));
+    ys.append(quantize(py));
+    steps.append(step | (extrude ? ExtrudeFlag : 0));
+    lastSegmentLine = line;
+}
+
+qint16 Toolpath::quantize(double v) const
+{
+    return qint16(qRound(qBound(-32767.0, v / scale, 32767.0)));
+}
+
+int Toolpath::segmentCount() const
+{
+    return xs.size();
+}
+
+int Toolpath::layerCount() const
+{
+    return layers.size();
+}
+
+const Toolpath::Layer &Toolpath::layer(int i) const
+{
+    return layers.at(i);
+}
+
+int Toolpath::layerEnd(int i) const
+{
+    if(i + 1 < layers.size()) return layers.at(i + 1).first;
+    return xs.size();
+}
+
+int Toolpath::layerOfLine(quint32 line) const
+{
+    int low = 0, high = layers.size() - 1;
+    while(low < high)
+    {
+        int mid = (low + high + 1) / 2;
+        if(layers.at(mid).firstLine <= line) low = mid;
+        else high = mid - 1;
+    }
+    return low;
+}
+
+float Toolpath::maxZ() const
+{
+    return zTop;
+}
+
+QSharedPointer<Toolpath> Toolpath::fromGCode(GCodeStore gcode, float extent,
+                                             QAtomicInt *generation, int current)
+{
+    QSharedPointer<Toolpath> toolpath(new Toolpath(extent));
+
+    toolpath->reserve(gcode.size());
+    for(int i = 0; i < gcode.size(); i++)
+    {
+        //Another file was opened, this result is not needed anymore
+        if(!(i & 0xfff) && generation->load() != current) return QSharedPointer<Toolpath>();
+
+        toolpath->addLine(gcode.line(i), gcode.length(i));
+    }
+
+    return toolpath;
+}
@@ -0,0 +1,68 @@
+#ifndef TOOLPATH_H
+#define TOOLPATH_H
+
+#include <QVector>
+#include <QString>
+#include <QSharedPointer>
+#include <QAtomicInt>
+
+#include "gcodecommand.h"
+#include "gcodestore.h"
+
+//Compact struct-of-arrays storage of the moves of a G-code file.
+//Every segment takes 6 bytes: quantized XY end point and the distance
+//in lines from the previous segment, with the top bit marking extrusion.
+class Toolpath
+{
+public:
+    typedef struct
+    {
+        float z;
+        int first;         //First segment of the layer
+        quint32 firstLine; //G-code line of the first segment
+    } Layer;
+
+    explicit Toolpath(float extent = 200);
+
+    void reserve(int lines);
+    void addLine(const char *line, int length);
+
+    int segmentCount() const;
+    int layerCount() const;
+    const Layer &layer(int i) const;
+    int layerEnd(int i) const;
+    int layerOfLine(quint32 line) const;
+    float maxZ() const;
+
+    inline float x(int i) const { return i < 0 ? 0 : xs.at(i) * scale; }
+    inline float y(int i) const { return i < 0 ? 0 : ys.at(i) * scale; }
+    inline bool extruding(int i) const { return steps.at(i) & ExtrudeFlag; }
+    inline quint32 lineStep(int i) const { return steps.at(i) & MaxStep; }
+
+    static QSharedPointer<Toolpath> fromGCode(GCodeStore gcode, float extent,
+                                              QAtomicInt *generation, int current);
+
+protected:
+    enum
+    {
+        ExtrudeFlag = 0x8000,
+        MaxStep = 0x7fff
+    };
+
+    QVector<qint16> xs, ys;
+    QVector<quint16> steps;
+    QVector<Layer> layers;
+    float scale;
+    float zTop;
+
+    //Interpreter state while building
+    quint32 lineIndex, lastSegmentLine;
+    double px, py, pz, pe;
+    bool relative, relativeE;
+    bool layerExtruded;
+
+    void addSegment(quint32 line, bool extrude);
+    inline qint16 quantize(double v) const;
+};
+
+#endif // TOOLPATH_H
@@ -0,0 +1,193 @@
+#include "toolpathview.h"
+
+ToolpathView::ToolpathView(QWidget *parent) : QWidget(parent)
+{
+    toolpath = 0;
+    cacheValid = false;
+    layer = 0;
+    currentLine = 0;
+    topView = false;
+    bedX = bedY = 200;
+    scale = 1;
+    cursorSegment = 0;
+    cursorLine = 0;
+
+    //Progress is drawn on top of the cached image, not redrawn from scratch
+    refresh.setInterval(200);
+    refresh.start();
+
+    connect(&refresh, SIGNAL(timeout()), this, SLOT(updateProgress()));
+}
+
+ToolpathView::~ToolpathView()
+{
+
+}
+
+void ToolpathView::setToolpath(const Toolpath *t)
+{
+    toolpath = t;
+    layer = 0;
+    cacheValid = false;
+    this->update();
+}
+
+void ToolpathView::setBedSize(float x, float y)
+{
+    bedX = x;
+    bedY = y;
+    cacheValid = false;
+    this->update();
+}
+
+void ToolpathView::setLayer(int l)
+{
+    if(l == layer) return;
+    layer = l;
+    cacheValid = false;
+    this->update();
+}
+
+void ToolpathView::setCurrentLine(long line)
+{
+    if(line < currentLine) cacheValid = false; //Print restarted
+    currentLine = line;
+}
+
+void ToolpathView::setTopView(bool top)
+{
+    topView = top;
+    cacheValid = false;
+    this->update();
+}
+
+void ToolpathView::updateProgress()
+{
+    if(!cacheValid)
+    {
+        this->update();
+        return;
+    }
+    if(!toolpath || !toolpath->layerCount() || cursorLine >= quint32(currentLine)) return;
+    if(cursorSegment >= toolpath->layerEnd(layer)) return;
+
+    QPainter painter(&cache);
+    highlight(painter);
+    this->update();
+}
+
+void ToolpathView::resizeEvent(QResizeEvent *re)
+{
+    cacheValid = false;
+    QWidget::resizeEvent(re);
+}
+
+void ToolpathView::paintEvent(QPaintEvent *pe)
+{
+    if(!cacheValid) render();
+
+    QPainter painter(this);
+    painter.drawImage(0, 0, cache);
+}
+
+void ToolpathView::fit()
+{
+    const double margin = 10;
+    double w = qMax(1.0, width() - 2*margin);
+    double h = qMax(1.0, height() - 2*margin);
+
+    if(topView)
+    {
+        scale = qMin(w / bedX, h / bedY);
+        origin = QPointF(margin, height() - margin);
+    }
+    else
+    {
+        //Isometric projection of the bed and the highest layer
+        double zmax = toolpath ? toolpath->maxZ() : 0;
+        scale = qMin(w / ((bedX + bedY) * 0.866), h / ((bedX + bedY) * 0.5 + zmax));
+        origin = QPointF(margin + bedY * 0.866 * scale, height() - margin);
+    }
+}
+
+QPointF ToolpathView::project(float x, float y, float z) const
+{
+    if(topView) return QPointF(origin.x() + x * scale, origin.y() - y * scale);
+    return QPointF(origin.x() + (x - y) * 0.866 * scale,
+                   origin.y() - ((x + y) * 0.5 + z) * scale);
+}
+
+void ToolpathView::render()
+{
+    cache = QImage(size(), QImage::Format_RGB32);
+    cache.fill(Qt::white);
+    cacheValid = true;
+    fit();
+
+    QPainter painter(&cache);
+
+    //Bed outline
+    painter.setPen(Qt::lightGray);
+    QPolygonF bed;
+    bed << project(0, 0, 0) << project(bedX, 0, 0) << project(bedX, bedY, 0) << project(0, bedY, 0);
+    painter.drawPolygon(bed);
+
+    if(!toolpath || !toolpath->layerCount()) return;
+    layer = qBound(0, layer, toolpath->layerCount() - 1);
+
+    //Top view only needs the layer below for reference
+    int firstLayer = topView ? qMax(0, layer - 1) : 0;
+    double lastZ = -1;
+
+    for(int l = firstLayer; l <= layer; l++)
+    {
+        bool top = (l == layer);
+        float z = toolpath->layer(l).z;
+
+        //Layers closer than a pixel to the last drawn one would only overdraw it
+        if(!top && !topView && (z - lastZ) * scale < 1) continue;
+        lastZ = z;
+
+        //Lower layers skip segments shorter than two pixels
+        double lod = top ? 0 : 2;
+        painter.setPen(top ? Qt::darkBlue : Qt::gray);
+
+        int first = toolpath->layer(l).first;
+        int end = toolpath->layerEnd(l);
+        QPointF last = project(toolpath->x(first - 1), toolpath->y(first - 1), z);
+
+        for(int i = first; i < end; i++)
+        {
+            QPointF p = project(toolpath->x(i), toolpath->y(i), z);
+
+            if(!toolpath->extruding(i)) last = p;
+            else if(!lod || (p - last).manhattanLength() >= lod)
+            {
+                painter.drawLine(last, p);
+                last = p;
+            }
+        }
+    }
+
+    cursorSegment = toolpath->layer(layer).first;
+    cursorLine = toolpath->layer(layer).firstLine;
+    highlight(painter);
+}
+
+void ToolpathView::highlight(QPainter &painter)
+{
+    int end = toolpath->layerEnd(layer);
+    float z = toolpath->layer(layer).z;
+
+    painter.setPen(QPen(Qt::red, 2));
+
+    while(cursorSegment < end && cursorLine < quint32(currentLine))
+    {
+        if(toolpath->extruding(cursorSegment))
+            painter.drawLine(project(toolpath->x(cursorSegment - 1), toolpath->y(cursorSegment - 1), z),
+                             project(toolpath->x(cursorSegment), toolpath->y(cursorSegment), z));
+
+        cursorSegment++;
+        if(cursorSegment < end) cursorLine += toolpath->lineStep(cursorSegment);
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef TOOLPATHVIEW_H
+#define TOOLPATHVIEW_H
+
+#include <QWidget>
+#include <QTimer>
+#include <QPainter>
+#include <QImage>
+
+#include "toolpath.h"
+
+class ToolpathView : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit ToolpathView(QWidget *parent = 0);
+    ~ToolpathView();
+    QTimer refresh;
+
+    void setToolpath(const Toolpath *t);
+    void setBedSize(float x, float y);
+
+protected:
+    const Toolpath *toolpath;
+    QImage cache;
+    bool cacheValid;
+    int layer;
+    long currentLine;
+    bool topView;
+    float bedX, bedY;
+    double scale;
+    QPointF origin;
+    int cursorSegment;   //First segment of the layer not yet highlighted
+    quint32 cursorLine;
+
+    virtual void paintEvent(QPaintEvent *pe);
+    virtual void resizeEvent(QResizeEvent *re);
+
+    void render();
+    void highlight(QPainter &painter);
+    void fit();
+    inline QPointF project(float x, float y, float z) const;
+
+public slots:
+    void setLayer(int l);
+    void setCurrentLine(long line);
+    void setTopView(bool top);
+    void updateProgress();
+};
+
+#endif // TOOLPATHVIEW_H
@@ -0,0 +1,60 @@
+#include "toolpathwindow.h"
+#include "ui_toolpathwindow.h"
+
+#include <QSettings>
+
+ToolpathWindow::ToolpathWindow(QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::ToolpathWindow)
+{
+    ui->setupUi(this);
+
+    QSettings settings;
+    ui->view->setBedSize(settings.value("printer/bedx", 200).toInt(),
+                         settings.value("printer/bedy", 200).toInt());
+
+    toolpath = 0;
+    setToolpath(0);
+}
+
+ToolpathWindow::~ToolpathWindow()
+{
+    delete ui;
+}
+
+void ToolpathWindow::setToolpath(const Toolpath *t)
+{
+    toolpath = t;
+    ui->view->setToolpath(t);
+
+    int layers = t ? t->layerCount() : 0;
+    ui->layerslider->setRange(0, qMax(0, layers - 1));
+    ui->layerslider->setValue(qMax(0, layers - 1));
+    ui->layerslider->setEnabled(layers > 1);
+    if(layers) on_layerslider_valueChanged(ui->layerslider->value());
+    else ui->layerlabel->setText("No file");
+}
+
+void ToolpathWindow::setCurrentLine(long line)
+{
+    ui->view->setCurrentLine(line);
+
+    //Follow the print, layer lookup is a binary search
+    if(toolpath && toolpath->layerCount() && ui->followbox->isChecked())
+        ui->layerslider->setValue(toolpath->layerOfLine(line));
+}
+
+void ToolpathWindow::on_layerslider_valueChanged(int value)
+{
+    ui->view->setLayer(value);
+
+    if(toolpath && toolpath->layerCount())
+        ui->layerlabel->setText("Layer " + QString::number(value + 1)
+                                + "/" + QString::number(toolpath->layerCount())
+                                + " Z" + QString::number(toolpath->layer(value).z));
+}
+
+void ToolpathWindow::on_topviewbox_toggled(bool checked)
+{
+    ui->view->setTopView(checked);
+}
@@ -0,0 +1,32 @@
+#ifndef TOOLPATHWINDOW_H
+#define TOOLPATHWINDOW_H
+
+#include <QDialog>
+
+#include "toolpath.h"
+
+namespace Ui {
+class ToolpathWindow;
+}
+
+class ToolpathWindow : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit ToolpathWindow(QWidget *parent = 0);
+    ~ToolpathWindow();
+
+    void setToolpath(const Toolpath *t);
+    void setCurrentLine(long line);
+
+private slots:
+    void on_layerslider_valueChanged(int value);
+    void on_topviewbox_toggled(bool checked);
+
+private:
+    Ui::ToolpathWindow *ui;
+    const Toolpath *toolpath;
+};
+
+#endif // TOOLPATHWINDOW_H
@@ -0,0 +1,205 @@
+#include "wirelogger.h"
+
+#include <string.h>
+
+WireLogger::WireLogger(QObject *parent) :
+    QThread(parent)
+{
+    ring = new char[RingSize];
+    head = 0;
+    tail = 0;
+    running = 0;
+    dropped = 0;
+    startTime = 0;
+}
+
+WireLogger::~WireLogger()
+{
+    stopLogging();
+    delete[] ring;
+}
+
+void WireLogger::startLogging(const QString &directory)
+{
+    if(running.load()) return;
+
+    this->directory = directory;
+    QDir().mkpath(directory);
+
+    startTime = QDateTime::currentMSecsSinceEpoch() * 1000;
+    clock.start();
+    running.storeRelease(1);
+
+    start(QThread::LowPriority);
+}
+
+void WireLogger::stopLogging()
+{
+    running.storeRelease(0);
+    wait();
+}
+
+void WireLogger::put(quint32 pos, const void *src, int length)
+{
+    quint32 offset = pos & RingMask;
+    int first = qMin<int>(length, RingSize - offset);
+
+    memcpy(ring + offset, src, first);
+    if(first < length) memcpy(ring, (const char*)src + first, length - first);
+}
+
+void WireLogger::get(quint32 pos, void *dst, int length) const
+{
+    quint32 offset = pos & RingMask;
+    int first = qMin<int>(length, RingSize - offset);
+
+    memcpy(dst, ring + offset, first);
+    if(first < length) memcpy((char*)dst + first, ring, length - first);
+}
+
+void WireLogger::log(char direction, const char *data, int length)
+{
+    if(!running.loadAcquire()) return;
+
+    while(length > 0 && (data[length-1] == '\n' || data[length-1] == '\r')) length--;
+    if(length > 0xffff) length = 0xffff;
+
+    quint32 h = head.load();
+    quint32 t = tail.loadAcquire();
+    quint32 need = HeaderSize + length;
+
+    if(RingSize - (h - t) < need) //Full, never wait for the disk
+    {
+        dropped.ref();
+        return;
+    }
+
+    qint64 time = startTime + clock.nsecsElapsed() / 1000;
+    quint16 size = length;
+
+    put(h, &time, 8);
+    put(h + 8, &direction, 1);
+    put(h + 9, &size, 2);
+    put(h + HeaderSize, data, length);
+
+    head.storeRelease(h + need);
+}
+
+void WireLogger::run()
+{
+    QFile file;
+    QByteArray text;
+    QByteArray line;
+    qint64 fileSize = 0;
+    QElapsedTimer sinceFlush;
+
+    text.reserve(BlockSize + 0x10000);
+    sinceFlush.start();
+
+    forever
+    {
+        bool stopping = !running.loadAcquire(); //Checked first, so the last lines are still drained
+
+        quint32 t = tail.load();
+        quint32 h = head.loadAcquire();
+
+        while(t != h)
+        {
+            qint64 time;
+            char direction;
+            quint16 size;
+
+            get(t, &time, 8);
+            get(t + 8, &direction, 1);
+            get(t + 9, &size, 2);
+            line.resize(size);
+            get(t + HeaderSize, line.data(), size);
+            t += HeaderSize + size;
+
+            text += QByteArray::number(time);
+            text += ' ';
+            text += direction;
+            text += ' ';
+            text += line;
+            text += '\n';
+        }
+        tail.storeRelease(t);
+
+        int lost = dropped.fetchAndStoreRelaxed(0);
+        if(lost) text += "# dropped " + QByteArray::number(lost) + " lines\n";
+
+        if(text.size() >= BlockSize || (!text.isEmpty() && (stopping || sinceFlush.elapsed() > 1000)))
+        {
+            if(!file.isOpen() || fileSize > MaxFileSize)
+            {
+                file.close();
+                file.setFileName(directory + "/wire-"
+                                 + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss-zzz")
+                                 + ".rrlog");
+                if(!file.open(QIODevice::WriteOnly))
+                {
+                    running.storeRelease(0);
+                    return;
+                }
+                fileSize = 0;
+                removeOldFiles();
+            }
+
+            writeBlock(file, text);
+            fileSize = file.size(); //Compressed, as it ends up on disk
+            text.clear();
+            sinceFlush.restart();
+        }
+
+        if(stopping) break;
+        msleep(50);
+    }
+}
+
+bool WireLogger::writeBlock(QFile &file, const QByteArray &text)
+{
+    QDataStream out(&file);
+
+    out << qCompress(text);
+    return file.flush();
+}
+
+void WireLogger::removeOldFiles()
+{
+    QDir dir(directory);
+    QStringList files = dir.entryList(QStringList("wire-*.rrlog"), QDir::Files, QDir::Name);
+
+    for(int i = 0; i < files.size() - MaxFiles; i++) dir.remove(files.at(i));
+}
+
+bool WireLogger::readFile(const QString &filename, QList<Record> &records)
+{
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+
+    while(!in.atEnd())
+    {
+        QByteArray block;
+        in >> block;
+        if(in.status() != QDataStream::Ok) break; //Cut short by a crash, keep what is there
+
+        QList<QByteArray> lines = qUncompress(block).split('\n');
+        foreach(const QByteArray &l, lines)
+        {
+            if(l.isEmpty() || l.startsWith('#')) continue;
+
+            int timeEnd = l.indexOf(' ');
+            if(timeEnd < 0 || l.size() < timeEnd + 3) continue;
+
+            Record r;
+            r.time = l.left(timeEnd).toLongLong();
+            r.direction = l.at(timeEnd + 1);
+            r.line = l.mid(timeEnd + 3);
+            records.append(r);
+        }
+    }
+
+    return true;
+}
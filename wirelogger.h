@@ -0,0 +1,73 @@
+#ifndef WIRELOGGER_H
+#define WIRELOGGER_H
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QDataStream>
+#include <QFile>
+#include <QDir>
+#include <QList>
+
+//Records every line going over the wire with a microsecond timestamp.
+//log() is called from the serial side and only copies into a ring,
+//dropping lines if it is full; the thread drains it into rotating files
+//made of qCompress'd blocks.
+class WireLogger : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum Direction
+    {
+        Sent = 'S',
+        Recieved = 'R'
+    };
+
+    typedef struct
+    {
+        qint64 time; //Microseconds since epoch
+        char direction;
+        QByteArray line;
+    } Record;
+
+    explicit WireLogger(QObject *parent = 0);
+    ~WireLogger();
+
+    void startLogging(const QString &directory);
+    void stopLogging();
+    void log(char direction, const char *data, int length);
+    inline void log(char direction, const QByteArray &line) { log(direction, line.constData(), line.size()); }
+    inline bool isLogging() const { return running.load(); }
+
+    static bool readFile(const QString &filename, QList<Record> &records);
+
+protected:
+    enum
+    {
+        RingSize = 1 << 22,
+        RingMask = RingSize - 1,
+        HeaderSize = 11,            //time, direction, length
+        BlockSize = 256 * 1024,     //Uncompressed bytes per block
+        MaxFileSize = 16 * 1024 * 1024, //Bytes on disk
+        MaxFiles = 10
+    };
+
+    char *ring;
+    QAtomicInt head;                //Moved only by log()
+    QAtomicInt tail;                //Moved only by the thread
+    QAtomicInt running;
+    QAtomicInt dropped;
+    QElapsedTimer clock;
+    qint64 startTime;
+    QString directory;
+
+    void run();
+    void put(quint32 pos, const void *src, int length);
+    void get(quint32 pos, void *dst, int length) const;
+    bool writeBlock(QFile &file, const QByteArray &text);
+    void removeOldFiles();
+};
+
+#endif // WIRELOGGER_H